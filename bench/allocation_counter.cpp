@@ -0,0 +1,36 @@
+// Standard library modules
+#include <cstdlib>
+#include <new>
+
+#include "allocation_counter.h"
+
+
+namespace {
+
+AllocationCount totals = { 0, 0 };
+
+void* counted_allocate(std::size_t size)
+{
+    ++totals.calls;
+    totals.bytes += size;
+    if(void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+} // namespace
+
+
+AllocationCount allocations()
+{
+    return totals;
+}
+
+
+// replacements for the global allocation functions
+void* operator new(std::size_t size) { return counted_allocate(size); }
+void* operator new[](std::size_t size) { return counted_allocate(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
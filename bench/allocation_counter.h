@@ -0,0 +1,22 @@
+#ifndef BENCH_ALLOCATION_COUNTER_H
+#define BENCH_ALLOCATION_COUNTER_H
+
+#include <cstddef>
+
+
+//----------------------------------------------------------------------
+// Global operator new instrumentation
+//----------------------------------------------------------------------
+
+// totals since program start, counted by the replacement operator new
+// in allocation_counter.cpp (single-threaded benchmarks only)
+struct AllocationCount
+{
+    std::size_t calls;
+    std::size_t bytes;
+};
+
+AllocationCount allocations();
+
+
+#endif // ifndef BENCH_ALLOCATION_COUNTER_H
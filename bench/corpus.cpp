@@ -0,0 +1,260 @@
+// Standard library modules
+#include <cstdint>
+#include <string>
+
+#include "corpus.h"
+
+
+namespace {
+
+const std::size_t CORPUS_SIZE = 4 << 20;
+
+// xorshift64: the corpora must be identical from run to run
+struct Random
+{
+    std::uint64_t state = 0x9E3779B97F4A7C15ULL;
+
+    std::uint64_t next()
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+
+    // uniform in [0, n)
+    unsigned int below(unsigned int n) { return static_cast<unsigned int>(next() % n); }
+};
+
+void append_int(std::string& out, long long value)
+{
+    out += std::to_string(value);
+}
+
+// a decimal with the given number of fraction digits
+void append_decimal(std::string& out, Random& rng, int int_max, int frac_digits)
+{
+    if(rng.below(2)) out += '-';
+    append_int(out, rng.below(int_max));
+    out += '.';
+    for(int i = 0; i < frac_digits; ++i)
+        out += static_cast<char>('0' + rng.below(10));
+}
+
+void append_word(std::string& out, Random& rng, int min_len, int max_len)
+{
+    int len = min_len + rng.below(max_len - min_len + 1);
+    for(int i = 0; i < len; ++i)
+        out += static_cast<char>('a' + rng.below(26));
+}
+
+// a sentence of words, occasionally with escapes or \u sequences
+void append_text(std::string& out, Random& rng, int words)
+{
+    static const char* const specials[] = { "\\n", "\\\"", "\\\\", "\\u00e9", "\\u2764", "\\ud83d\\ude00", "/" };
+    for(int i = 0; i < words; ++i) {
+        if(i) out += ' ';
+        append_word(out, rng, 2, 9);
+        if(!rng.below(12)) out += specials[rng.below(7)];
+    }
+}
+
+// wrap elements produced by element() in a top-level array of ~CORPUS_SIZE
+template<typename F>
+std::string build_array(F element)
+{
+    Random rng;
+    std::string json = "[";
+    element(json, rng);
+    while(json.size() < CORPUS_SIZE) {
+        json += ',';
+        element(json, rng);
+    }
+    json += "]";
+    return json;
+}
+
+std::string deep()
+{
+    return build_array([](std::string& out, Random& rng) {
+        const int depth = 256 + rng.below(256);
+        for(int i = 0; i < depth; ++i)
+            out += (i % 2) ? "[" : "{\"level\":";
+        append_int(out, depth);
+        for(int i = depth; i-- > 0;)
+            out += (i % 2) ? "]" : "}";
+    });
+}
+
+std::string wide()
+{
+    return build_array([](std::string& out, Random& rng) {
+        switch(rng.below(4)) {
+            case 0: append_int(out, rng.below(100000)); break;
+            case 1: out += rng.below(2) ? "true" : "false"; break;
+            case 2: out += "null"; break;
+            default: out += '"'; append_word(out, rng, 1, 6); out += '"'; break;
+        }
+    });
+}
+
+std::string strings()
+{
+    return build_array([](std::string& out, Random& rng) {
+        out += '"';
+        append_text(out, rng, 10 + rng.below(60));
+        out += '"';
+    });
+}
+
+std::string numbers()
+{
+    return build_array([](std::string& out, Random& rng) {
+        switch(rng.below(4)) {
+            case 0: append_int(out, static_cast<long long>(rng.next() >> 12) - (1ll << 51)); break;
+            case 1: append_int(out, rng.below(1000)); break;
+            case 2: append_decimal(out, rng, 10000, 1 + rng.below(8)); break;
+            default:
+                append_decimal(out, rng, 10, 6);
+                out += rng.below(2) ? "e+" : "E-";
+                append_int(out, rng.below(300));
+                break;
+        }
+    });
+}
+
+// shaped like canada.json: a FeatureCollection of long coordinate rings
+std::string canada()
+{
+    Random rng;
+    std::string json = "{\"type\":\"FeatureCollection\",\"features\":[";
+    for(int feature = 0; json.size() < CORPUS_SIZE; ++feature) {
+        if(feature) json += ',';
+        json += "{\"type\":\"Feature\",\"properties\":{\"name\":\"Canada\"},"
+                "\"geometry\":{\"type\":\"Polygon\",\"coordinates\":[";
+        for(int ring = 0; ring < 8; ++ring) {
+            if(ring) json += ',';
+            json += '[';
+            for(int point = 0; point < 512; ++point) {
+                if(point) json += ',';
+                json += '[';
+                append_decimal(json, rng, 180, 15);
+                json += ',';
+                append_decimal(json, rng, 90, 15);
+                json += ']';
+            }
+            json += ']';
+        }
+        json += "]}}";
+    }
+    json += "]}";
+    return json;
+}
+
+// shaped like twitter.json: statuses with a nested user and entities
+std::string twitter()
+{
+    Random rng;
+    std::string json = "{\"statuses\":[";
+    for(int status = 0; json.size() < CORPUS_SIZE; ++status) {
+        if(status) json += ',';
+        json += "{\"created_at\":\"Sun Aug 31 00:29:15 +0000 2014\",\"id\":";
+        append_int(json, 505874924095815681ll + status);
+        json += ",\"id_str\":\"";
+        append_int(json, 505874924095815681ll + status);
+        json += "\",\"text\":\"";
+        append_text(json, rng, 12 + rng.below(10));
+        json += "\",\"truncated\":false,\"in_reply_to_status_id\":null,"
+                "\"user\":{\"id\":";
+        append_int(json, rng.below(1 << 30));
+        json += ",\"name\":\"";
+        append_word(json, rng, 4, 12);
+        json += "\",\"screen_name\":\"";
+        append_word(json, rng, 4, 12);
+        json += "\",\"description\":\"";
+        append_text(json, rng, 8);
+        json += "\",\"followers_count\":";
+        append_int(json, rng.below(100000));
+        json += ",\"verified\":false,\"profile_background_color\":\"C0DEED\"},"
+                "\"entities\":{\"hashtags\":[],\"urls\":[],\"user_mentions\":[{\"screen_name\":\"";
+        append_word(json, rng, 4, 12);
+        json += "\",\"indices\":[";
+        append_int(json, rng.below(40));
+        json += ",";
+        append_int(json, 40 + rng.below(40));
+        json += "]}]},\"retweet_count\":";
+        append_int(json, rng.below(500));
+        json += ",\"favorited\":false,\"lang\":\"ja\"}";
+    }
+    json += "]}";
+    return json;
+}
+
+// shaped like citm_catalog.json: objects keyed by numeric ids
+std::string citm()
+{
+    Random rng;
+    std::string json = "{\"events\":{";
+    for(int event = 0; json.size() < CORPUS_SIZE; ++event) {
+        if(event) json += ',';
+        json += '"';
+        append_int(json, 138586341 + event);
+        json += "\":{\"description\":null,\"id\":";
+        append_int(json, 138586341 + event);
+        json += ",\"logo\":\"/images/UE0AAAAACEKo6QAAAAZDSVRN\",\"name\":\"";
+        append_text(json, rng, 3);
+        json += "\",\"subTopicIds\":[";
+        for(int i = 0, n = 2 + rng.below(6); i < n; ++i) {
+            if(i) json += ',';
+            append_int(json, 337184262 + rng.below(1000));
+        }
+        json += "],\"subjectCode\":null,\"subtitle\":null,\"topicIds\":[";
+        for(int i = 0, n = 1 + rng.below(3); i < n; ++i) {
+            if(i) json += ',';
+            append_int(json, 324846099 + rng.below(1000));
+        }
+        json += "],\"prices\":[";
+        for(int i = 0, n = 1 + rng.below(4); i < n; ++i) {
+            if(i) json += ',';
+            json += "{\"amount\":";
+            append_int(json, 9000 + rng.below(100000));
+            json += ",\"audienceSubCategoryId\":337100890,\"seatCategoryId\":";
+            append_int(json, 338937295 + rng.below(100));
+            json += '}';
+        }
+        json += "]}";
+    }
+    json += "}}";
+    return json;
+}
+
+} // namespace
+
+
+const std::string& generated_corpus(CorpusShape shape)
+{
+    static std::string corpora[CORPUS_SHAPE_COUNT];
+    std::string& json = corpora[shape];
+    if(json.empty()) {
+        switch(shape) {
+            case DEEP: json = deep(); break;
+            case WIDE: json = wide(); break;
+            case STRINGS: json = strings(); break;
+            case NUMBERS: json = numbers(); break;
+            case CANADA: json = canada(); break;
+            case TWITTER: json = twitter(); break;
+            case CITM: json = citm(); break;
+            default: break;
+        }
+    }
+    return json;
+}
+
+
+const char* corpus_name(CorpusShape shape)
+{
+    static const char* const names[CORPUS_SHAPE_COUNT] = {
+        "deep", "wide", "strings", "numbers", "canada", "twitter", "citm"
+    };
+    return shape < CORPUS_SHAPE_COUNT ? names[shape] : "unknown";
+}
@@ -0,0 +1,30 @@
+#ifndef BENCH_CORPUS_H
+#define BENCH_CORPUS_H
+
+#include <string>
+
+
+//----------------------------------------------------------------------
+// Generated benchmark corpora
+//----------------------------------------------------------------------
+
+// document shapes; each corpus is a few MB of deterministic JSON
+enum CorpusShape {
+    DEEP,     // objects and arrays nested hundreds of levels
+    WIDE,     // one flat array of small scalars
+    STRINGS,  // long string values, some with escapes
+    NUMBERS,  // integers, decimals and exponents
+    CANADA,   // GeoJSON polygons: arrays of coordinate pairs
+    TWITTER,  // status objects with nested users and unicode text
+    CITM,     // event catalogue: id-keyed objects and int arrays
+    CORPUS_SHAPE_COUNT
+};
+
+// the corpus for shape (built on first use)
+const std::string& generated_corpus(CorpusShape shape);
+
+// short name used as the benchmark label
+const char* corpus_name(CorpusShape shape);
+
+
+#endif // ifndef BENCH_CORPUS_H
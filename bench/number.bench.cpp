@@ -0,0 +1,115 @@
+// Standard library modules
+#include <string>
+
+// libwjson modules
+#include <core/token.h>
+#include <core/json_exception.h>
+#include <core/json_string.h>
+#include <core/number.h>
+#include <core/structural_index.h>
+#include <core/lexer.h>
+#include <core/parser.h>
+#include <core/ast.h>
+#include <core/arena.h>
+#include <core/tape.h>
+
+// Google Benchmark
+#include <benchmark/benchmark.h>
+
+//----------------------------------------------------------------------
+// Corpus
+//----------------------------------------------------------------------
+
+// ~8 MB array of copies of tests/input_files/numbers.json
+static const std::string& corpus()
+{
+    static std::string json;
+    if(json.empty()) {
+        const std::string element =
+            "{\"int\":3,\"another int\":103,\"negative\":-20,\"decimal\":1.3,\"leading 0 decimal\":0.5,"
+            "\"negative decimal\":-51.92,\"negative leading 0 decimal\":-0.336,\"exp\":1e4,\"big exp\":2e21,"
+            "\"bigger exp\":11e3,\"negative exp\":-4e5,\"exp with plus\":81e+1,\"exp with 0\":51e0,"
+            "\"exp with minus\":37e-3,\"negative exp with plus\":-81e+1,\"negative exp with minus\":-23e-6,"
+            "\"exp with frac and exp\":51.53e29}";
+        json = "[" + element;
+        while(json.size() < (8 << 20))
+            json += "," + element;
+        json += "]";
+    }
+    return json;
+}
+
+// every number in the parsed corpus
+static std::vector<SimpleRValue*> numbers(JSONDocument& doc)
+{
+    std::vector<SimpleRValue*> out;
+    for(RValue* element : static_cast<Array&>(*doc.root).values)
+        for(Record& r : static_cast<JSON&>(*element).records)
+            out.push_back(static_cast<SimpleRValue*>(r.value));
+    return out;
+}
+
+//----------------------------------------------------------------------
+// Benchmarks
+//----------------------------------------------------------------------
+
+// what consumers did before: copy the lexeme and call std::stod
+static void BM_Stod(benchmark::State& state)
+{
+    JSONDocument doc;
+    Lexer lexer(corpus());
+    Parser parser(lexer);
+    parser.parse(doc);
+    std::vector<SimpleRValue*> values = numbers(doc);
+    for(auto _ : state) {
+        double sum = 0;
+        for(SimpleRValue* v : values)
+            sum += std::stod(std::string(v->value.lexeme()));
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+BENCHMARK(BM_Stod)->Unit(benchmark::kMillisecond);
+
+// first access: integer fast path, from_chars for the rest
+static void BM_AsDoubleFirstAccess(benchmark::State& state)
+{
+    for(auto _ : state) {
+        state.PauseTiming();
+        JSONDocument doc;
+        Lexer lexer(corpus());
+        Parser parser(lexer);
+        parser.parse(doc);
+        std::vector<SimpleRValue*> values = numbers(doc);
+        state.ResumeTiming();
+        double sum = 0;
+        for(SimpleRValue* v : values)
+            sum += v->as_double();
+        benchmark::DoNotOptimize(sum);
+        state.SetItemsProcessed(state.items_processed() + values.size());
+    }
+}
+BENCHMARK(BM_AsDoubleFirstAccess)->Unit(benchmark::kMillisecond);
+
+// repeated access hits the per-node cache
+static void BM_AsDoubleCached(benchmark::State& state)
+{
+    JSONDocument doc;
+    Lexer lexer(corpus());
+    Parser parser(lexer);
+    parser.parse(doc);
+    std::vector<SimpleRValue*> values = numbers(doc);
+    for(SimpleRValue* v : values)
+        v->as_double();
+    for(auto _ : state) {
+        double sum = 0;
+        for(SimpleRValue* v : values)
+            sum += v->as_double();
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+BENCHMARK(BM_AsDoubleCached)->Unit(benchmark::kMillisecond);
+
+
+BENCHMARK_MAIN();
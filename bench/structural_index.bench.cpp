@@ -0,0 +1,87 @@
+// Standard library modules
+#include <string>
+
+// libwjson modules
+#include <core/token.h>
+#include <core/json_exception.h>
+#include <core/json_string.h>
+#include <core/structural_index.h>
+#include <core/lexer.h>
+
+// Google Benchmark
+#include <benchmark/benchmark.h>
+
+//----------------------------------------------------------------------
+// Corpus
+//----------------------------------------------------------------------
+
+// ~16 MB array built from the RFC 8259 array example
+static const std::string& corpus()
+{
+    static std::string json;
+    if(json.empty()) {
+        const std::string element =
+            "{\n       \"precision\": \"zip\",\n       \"Latitude\":  37.7668,\n"
+            "       \"Longitude\": -122.3959,\n       \"Address\":   \"\",\n"
+            "       \"City\":      \"SAN \\\"FRANCISCO\\\"\",\n       \"State\":     \"CA\",\n"
+            "       \"Zip\":       \"94107\",\n       \"Country\":   \"US\"\n    }";
+        json = "[\n    " + element;
+        while(json.size() < (16 << 20))
+            json += ",\n    " + element;
+        json += "\n]\n";
+    }
+    return json;
+}
+
+//----------------------------------------------------------------------
+// Benchmarks
+//----------------------------------------------------------------------
+
+// the lexer's byte-at-a-time loop over the same input
+static void BM_LexerByteLoop(benchmark::State& state)
+{
+    const std::string& json = corpus();
+    for(auto _ : state) {
+        Lexer lexer(json);
+        while(lexer.next_token().type() != EOS) {}
+    }
+    state.SetBytesProcessed(state.iterations() * json.size());
+}
+BENCHMARK(BM_LexerByteLoop)->Unit(benchmark::kMillisecond);
+
+// stage one only
+static void BM_StructuralIndex(benchmark::State& state)
+{
+    StructuralIndex::Implementation impl = static_cast<StructuralIndex::Implementation>(state.range(0));
+    if(!StructuralIndex::supported(impl)) {
+        state.SkipWithError("not supported by this CPU");
+        return;
+    }
+    state.SetLabel(StructuralIndex::name(impl));
+    const std::string& json = corpus();
+    StructuralIndex index;
+    for(auto _ : state) {
+        index.build(json, impl);
+        benchmark::DoNotOptimize(index.positions.data());
+    }
+    state.SetBytesProcessed(state.iterations() * json.size());
+}
+BENCHMARK(BM_StructuralIndex)
+    ->Arg(StructuralIndex::SCALAR)->Arg(StructuralIndex::SSE42)->Arg(StructuralIndex::AVX2)
+    ->Unit(benchmark::kMillisecond);
+
+// stage one followed by the lexer consuming the index
+static void BM_LexerIndexed(benchmark::State& state)
+{
+    const std::string& json = corpus();
+    for(auto _ : state) {
+        Lexer lexer(json);
+        lexer.use_structural_index();
+        while(lexer.next_token().type() != EOS) {}
+    }
+    state.SetBytesProcessed(state.iterations() * json.size());
+}
+BENCHMARK(BM_LexerIndexed)->Unit(benchmark::kMillisecond);
+
+
+BENCHMARK_MAIN();
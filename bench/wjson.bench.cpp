@@ -0,0 +1,187 @@
+// Standard library modules
+#include <memory>
+#include <sstream>
+#include <streambuf>
+#include <string>
+
+// libwjson modules
+#include <core/token.h>
+#include <core/lexer.h>
+#include <core/parser.h>
+#include <core/ast.h>
+#include <core/binary_readers.h>
+#include <printer/printer.h>
+#include <printer/binary_writers.h>
+
+// Google Benchmark
+#include <benchmark/benchmark.h>
+
+#include "corpus.h"
+#include "allocation_counter.h"
+
+//----------------------------------------------------------------------
+// Helpers
+//----------------------------------------------------------------------
+
+// an output stream buffer that discards everything, so the printers are
+// measured without the cost of a real sink
+class NullBuffer : public std::streambuf
+{
+protected:
+    int_type overflow(int_type c) override { return traits_type::not_eof(c); }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+static std::unique_ptr<JSONDocument> parse(const std::string& json)
+{
+    std::unique_ptr<JSONDocument> doc(new JSONDocument);
+    Lexer lexer(json);
+    Parser parser(lexer);
+    parser.parse(*doc);
+    return doc;
+}
+
+// label the run with the corpus name and report MB/s
+static void report(benchmark::State& state, CorpusShape shape)
+{
+    state.SetLabel(corpus_name(shape));
+    state.SetBytesProcessed(state.iterations() * generated_corpus(shape).size());
+}
+
+// ... and the heap use of one pass over the document
+static void report(benchmark::State& state, CorpusShape shape,
+                   const AllocationCount& before, const AllocationCount& after)
+{
+    report(state, shape);
+    double runs = static_cast<double>(state.iterations());
+    state.counters["allocs/doc"] = (after.calls - before.calls) / runs;
+    state.counters["alloc_bytes/doc"] = (after.bytes - before.bytes) / runs;
+}
+
+static void all_shapes(benchmark::internal::Benchmark* b)
+{
+    for(int shape = 0; shape < CORPUS_SHAPE_COUNT; ++shape)
+        b->Arg(shape);
+    b->Unit(benchmark::kMillisecond);
+}
+
+//----------------------------------------------------------------------
+// Benchmarks
+//----------------------------------------------------------------------
+
+// Lexer::next_token() over the whole input
+static void BM_Lex(benchmark::State& state)
+{
+    CorpusShape shape = static_cast<CorpusShape>(state.range(0));
+    const std::string& json = generated_corpus(shape);
+    AllocationCount before = allocations();
+    for(auto _ : state) {
+        Lexer lexer(json);
+        while(lexer.next_token().type() != EOS) {}
+    }
+    report(state, shape, before, allocations());
+}
+BENCHMARK(BM_Lex)->Apply(all_shapes);
+
+// Parser::parse() end to end, including freeing the document
+static void BM_Parse(benchmark::State& state)
+{
+    CorpusShape shape = static_cast<CorpusShape>(state.range(0));
+    const std::string& json = generated_corpus(shape);
+    AllocationCount before = allocations();
+    for(auto _ : state) {
+        std::unique_ptr<JSONDocument> doc = parse(json);
+        benchmark::DoNotOptimize(doc->root);
+    }
+    report(state, shape, before, allocations());
+}
+BENCHMARK(BM_Parse)->Apply(all_shapes);
+
+// the same documents decoded from CBOR and MessagePack into the same tree;
+// throughput is reported against the JSON text size so it compares
+// directly with BM_Parse
+template<typename Writer, typename Reader>
+static void parse_binary(benchmark::State& state)
+{
+    CorpusShape shape = static_cast<CorpusShape>(state.range(0));
+    std::ostringstream encoded;
+    {
+        std::unique_ptr<JSONDocument> doc = parse(generated_corpus(shape));
+        Writer writer(encoded);
+        doc->accept(writer);
+    }
+    std::string bytes = encoded.str();
+    Reader reader;
+    AllocationCount before = allocations();
+    for(auto _ : state) {
+        JSONDocument doc;
+        reader.parse(bytes, doc);
+        benchmark::DoNotOptimize(doc.root);
+    }
+    report(state, shape, before, allocations());
+    state.counters["encoded_bytes"] = static_cast<double>(bytes.size());
+}
+
+static void BM_ParseCBOR(benchmark::State& state)
+{
+    parse_binary<CBORWriter, CBORReader>(state);
+}
+BENCHMARK(BM_ParseCBOR)->Apply(all_shapes);
+
+static void BM_ParseMessagePack(benchmark::State& state)
+{
+    parse_binary<MessagePackWriter, MessagePackReader>(state);
+}
+BENCHMARK(BM_ParseMessagePack)->Apply(all_shapes);
+
+// Printer as wjsonformat uses it (one tab per level)
+static void BM_PrintFormatted(benchmark::State& state)
+{
+    CorpusShape shape = static_cast<CorpusShape>(state.range(0));
+    std::unique_ptr<JSONDocument> doc = parse(generated_corpus(shape));
+    NullBuffer sink;
+    std::ostream out(&sink);
+    AllocationCount before = allocations();
+    for(auto _ : state) {
+        Printer printer(out, 1, '\t');
+        doc->accept(printer);
+    }
+    report(state, shape, before, allocations());
+}
+BENCHMARK(BM_PrintFormatted)->Apply(all_shapes);
+
+// compact Printer, as wjsoncompact uses it
+static void BM_PrintCompact(benchmark::State& state)
+{
+    CorpusShape shape = static_cast<CorpusShape>(state.range(0));
+    std::unique_ptr<JSONDocument> doc = parse(generated_corpus(shape));
+    NullBuffer sink;
+    std::ostream out(&sink);
+    AllocationCount before = allocations();
+    for(auto _ : state) {
+        Printer printer(out);
+        doc->accept(printer);
+    }
+    report(state, shape, before, allocations());
+}
+BENCHMARK(BM_PrintCompact)->Apply(all_shapes);
+
+// JSONDocument destruction only; parsing is excluded from the timing
+static void BM_Teardown(benchmark::State& state)
+{
+    CorpusShape shape = static_cast<CorpusShape>(state.range(0));
+    const std::string& json = generated_corpus(shape);
+    for(auto _ : state) {
+        state.PauseTiming();
+        std::unique_ptr<JSONDocument> doc = parse(json);
+        state.ResumeTiming();
+        doc.reset();
+    }
+    report(state, shape);
+}
+// arena teardown takes microseconds, so a time-based iteration count would
+// spend minutes re-parsing between the timed sections
+BENCHMARK(BM_Teardown)->Apply(all_shapes)->Iterations(32);
+
+
+BENCHMARK_MAIN();
@@ -0,0 +1,47 @@
+#include <iostream>
+#include <memory>
+#include <string>
+#include <system_error>
+
+// libwjson modules
+#include <core/json_exception.h>
+#include <core/binary_document.h>
+#include <core/mapped_file.h>
+#include <printer/minifier.h>
+
+using namespace std;
+
+
+// convert JSON to the binary encoding, or binary back to compact JSON,
+// whichever the input is; neither direction builds a tree
+int main(int argc, char* argv[])
+{
+  // map the input file, or standard input if no input file given
+  unique_ptr<MappedFile> input;
+  try {
+    if (argc == 2)
+      input.reset(new MappedFile(argv[1]));
+    else
+      input.reset(new MappedFile(0));
+  } catch (system_error& e) {
+    cerr << e.what() << endl;
+    exit(1);
+  }
+
+  try {
+    if (BinaryDocument::is_binary(input->data())) {
+      BinaryDocument doc(input->data());
+      Minifier minifier(cout);
+      doc.root().replay(minifier);
+      minifier.end_document();
+    } else {
+      string out;
+      BinaryWriter writer(out);
+      writer.write(input->data());
+      cout.write(out.data(), out.size());
+    }
+  } catch (JSONException e) {
+    cerr << e.to_string() << endl;
+    exit(1);
+  }
+}
@@ -1,40 +1,98 @@
 #include <iostream>
-#include <fstream>
+#include <cstring>
+#include <memory>
+#include <system_error>
 
 // libwjson modules
-#include <core/token.cpp>
-#include <core/json_exception.cpp>
-#include <core/lexer.cpp>
-#include <core/parser.cpp>
-#include <core/ast.cpp>
-
-#include "wjsonformat.cpp"
+#include <core/json_exception.h>
+#include <core/lexer.h>
+#include <core/parser.h>
+#include <core/ast.h>
+#include <core/mapped_file.h>
+#include <core/ndjson.h>
+#include <core/parallel_parser.h>
+#include <printer/printer.h>
+#include <printer/stream_printer.h>
 
 using namespace std;
 
 
 int main(int argc, char* argv[])
 {
-  // use standard input if no input file given
-  istream* input_stream = &cin;
-  if (argc == 2)
-    input_stream = new ifstream(argv[1]);
+  // streamed input is read through cin in large blocks
+  ios::sync_with_stdio(false);
+
+  // --lines: the input is JSON Lines, one document per line
+  // --stream: format straight from the parser without building a tree
+  // (bounded memory; output is cut short at an error)
+  bool lines = false;
+  bool stream = false;
+  for (; argc > 1; --argc, ++argv) {
+    if (!strcmp(argv[1], "--lines"))
+      lines = true;
+    else if (!strcmp(argv[1], "--stream"))
+      stream = true;
+    else
+      break;
+  }
+
+  // map the input file, or standard input if no input file given (JSON
+  // Lines or --stream on standard input are streamed instead, so a pipe of
+  // any length needs bounded memory)
+  unique_ptr<MappedFile> input;
+  try {
+    if (argc == 2)
+      input.reset(new MappedFile(argv[1]));
+    else if (!lines && !stream)
+      input.reset(new MappedFile(0));
+  } catch (system_error& e) {
+    cerr << e.what() << endl;
+    exit(1);
+  }
 
-  // create the lexer & parser
-  Lexer lexer(*input_stream);
-  Parser parser(lexer);
+  if (lines) {
+    try {
+      Printer printer(cout, 1, '\t');
+      NDJSONReader reader;
+      auto print = [&](JSONDocument& doc, size_t) {
+        printer.print_record(doc);
+      };
+      if (input)
+        reader.read(input->data(), print);
+      else
+        reader.read(cin, print);
+    } catch (JSONException e) {
+      cerr << e.to_string() << endl;
+      exit(1);
+    }
+    return 0;
+  }
+
+  if (stream) {
+    try {
+      StreamPrinter printer(cout, 1, '\t');
+      if (input)
+        printer.print(input->data());
+      else
+        printer.print(cin);
+    } catch (JSONException e) {
+      cout.flush();
+      cerr << e.to_string() << endl;
+      exit(1);
+    }
+    return 0;
+  }
 
-  // read each token in the file until EOS or error
+  // parse the file (on every core if it is one large array); tokens
+  // point into the mapping
   try {
     JSONDocument ast_root_node;
-    parser.parse(ast_root_node);
-    Printer printer(cout);
+    ParallelParser parser;
+    parser.parse(input->data(), ast_root_node);
+    Printer printer(cout, 1, '\t');
     ast_root_node.accept(printer);
   } catch (JSONException e) {
     cerr << e.to_string() << endl;
     exit(1);
   }
-  // clean up the input stream
-  if (input_stream != &cin)
-    delete input_stream;
 }
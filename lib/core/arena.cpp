@@ -0,0 +1,80 @@
+#ifndef ARENA_CPP
+#define ARENA_CPP
+
+#include <cstdlib>
+#include "arena.h"
+
+// first block size, and the size blocks stop doubling at
+static const std::size_t MIN_BLOCK_SIZE = 4096;
+static const std::size_t MAX_BLOCK_SIZE = 1 << 20;
+
+
+Arena::Arena()
+  : head(nullptr), curr(nullptr), end(nullptr), reserved(0)
+{
+}
+
+
+Arena::~Arena()
+{
+  release();
+}
+
+
+void Arena::release()
+{
+  while (head) {
+    Block* prev = head->prev;
+    std::free(head);
+    head = prev;
+  }
+  curr = end = nullptr;
+  reserved = 0;
+}
+
+
+void Arena::absorb(Arena& other)
+{
+  if (!other.head) return;
+  if (!head) {
+    head = other.head;
+    curr = other.curr;
+    end = other.end;
+  } else {
+    // keep allocating from our head block; other's blocks go behind it
+    Block* oldest = other.head;
+    while (oldest->prev) oldest = oldest->prev;
+    oldest->prev = head->prev;
+    head->prev = other.head;
+  }
+  reserved += other.reserved;
+  other.head = nullptr;
+  other.curr = other.end = nullptr;
+  other.reserved = 0;
+}
+
+
+std::size_t Arena::capacity() const
+{
+  return reserved;
+}
+
+
+void Arena::grow(std::size_t min_size)
+{
+  // double with each block so large documents need few blocks
+  std::size_t size = head ? head->size * 2 : MIN_BLOCK_SIZE;
+  if (size > MAX_BLOCK_SIZE) size = MAX_BLOCK_SIZE;
+  if (size < min_size) size = min_size;
+  Block* block = static_cast<Block*>(std::malloc(sizeof(Block) + size));
+  if (!block) throw std::bad_alloc();
+  block->prev = head;
+  block->size = size;
+  head = block;
+  curr = reinterpret_cast<char*>(block + 1);
+  end = curr + size;
+  reserved += size;
+}
+
+
+#endif // ifndef ARENA_CPP
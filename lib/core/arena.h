@@ -0,0 +1,95 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+
+//----------------------------------------------------------------------
+// Bump allocator backing a JSONDocument
+//----------------------------------------------------------------------
+
+// Memory is carved sequentially out of large blocks and is only released
+// all at once when the arena is destroyed. Destructors of objects created
+// in the arena are never run, so only trivially destructible state (or
+// state that itself lives in the arena) may be placed in it.
+class Arena
+{
+  public:
+    Arena();
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // return size bytes aligned to align (a power of two)
+    void* allocate(std::size_t size, std::size_t align);
+
+    // construct a T in the arena
+    template<typename T, typename... Args>
+    T* create(Args&&... args);
+
+    // copy n objects into one contiguous array in the arena
+    template<typename T>
+    T* copy_array(const T* src, std::size_t n);
+
+    // free every block (invalidates everything allocated so far)
+    void release();
+
+    // take over every block of other, which is left empty; what was
+    // allocated in other now lives (and is freed) with this arena
+    void absorb(Arena& other);
+
+    // total bytes reserved from the system
+    std::size_t capacity() const;
+
+  private:
+    // header of each block; the usable bytes follow it
+    struct Block
+    {
+      Block* prev;
+      std::size_t size;
+    };
+
+    Block* head;
+    char* curr;
+    char* end;
+    std::size_t reserved;
+
+    // start a new block with room for at least min_size bytes
+    void grow(std::size_t min_size);
+};
+
+
+// allocation is on the parser's hot path, so keep it inline
+inline void* Arena::allocate(std::size_t size, std::size_t align)
+{
+  std::uintptr_t p = (reinterpret_cast<std::uintptr_t>(curr) + align - 1) & ~(align - 1);
+  if (p + size > reinterpret_cast<std::uintptr_t>(end)) {
+    grow(size + align);
+    p = (reinterpret_cast<std::uintptr_t>(curr) + align - 1) & ~(align - 1);
+  }
+  curr = reinterpret_cast<char*>(p + size);
+  return reinterpret_cast<void*>(p);
+}
+
+template<typename T, typename... Args>
+T* Arena::create(Args&&... args)
+{
+  return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+}
+
+template<typename T>
+T* Arena::copy_array(const T* src, std::size_t n)
+{
+  if (!n) return nullptr;
+  T* dst = static_cast<T*>(allocate(sizeof(T) * n, alignof(T)));
+  for (std::size_t i = 0; i < n; ++i)
+    new (dst + i) T(src[i]);
+  return dst;
+}
+
+
+#endif // ifndef ARENA_H
@@ -1,7 +1,11 @@
 #ifndef AST_CPP
 #define AST_CPP
 
+#include <cstring>
+#include <limits>
 #include "ast.h"
+#include "json_string.h"
+#include "symbol_table.h"
 
 
 //----------------------------------------------------------------------
@@ -14,6 +18,14 @@ void Record::accept(Visitor& v) {
 }
 
 
+// the key with escape sequences decoded (UTF-8)
+std::string Record::key_string() const {
+  std::string s;
+  unescape_json_string(key.lexeme(), s);
+  return s;
+}
+
+
 // JSONDocument
 void JSONDocument::accept(Visitor& v) {
   v.visit(*this);
@@ -25,15 +37,15 @@ void JSONDocument::accept(Visitor& v) {
 //----------------------------------------------------------------------
 
 // JSON
-// cleanup memory
-JSON::~JSON() {
-  for (Record* d : records) delete d;
+// JSON is always JSON type
+JSON::JSON() {
+  type = JSON_TYPE;
 }
 
 // return first token (first primitive value)
 Token JSON::first_token() {
   return this->records.size()
-    ? this->records.front()->key
+    ? this->records.front().key
     : this->rbrace_token;
 }
 
@@ -42,11 +54,89 @@ void JSON::accept(Visitor& v) {
   v.visit(*this);
 }
 
+namespace {
+
+// the key of r, decoded into storage only if it has escapes
+std::string_view decoded_key(const Record& r, std::string& storage) {
+  std::string_view raw = r.key.lexeme();
+  if (!std::memchr(raw.data(), '\\', raw.size()))
+    return raw;
+  storage.clear();
+  unescape_json_string(raw, storage);
+  return storage;
+}
+
+} // namespace
+
+void JSON::fill_index() {
+  std::size_t capacity = std::size_t(index_mask) + 1;
+  std::memset(index, 0, capacity * sizeof(std::uint32_t));
+  std::string storage, other;
+  for (std::size_t i = 0; i < records.size(); ++i) {
+    std::string_view key = decoded_key(records[i], storage);
+    std::uint32_t slot = hash_bytes(key) & index_mask;
+    // keep the first of duplicate keys
+    while (index[slot] && decoded_key(records[index[slot] - 1], other) != key)
+      slot = (slot + 1) & index_mask;
+    if (!index[slot])
+      index[slot] = static_cast<std::uint32_t>(i + 1);
+  }
+}
+
+RValue* JSON::find(std::string_view key) const {
+  std::string storage;
+  if (!index) {
+    for (const Record& r : records)
+      if (decoded_key(r, storage) == key)
+        return r.value;
+    return nullptr;
+  }
+  for (std::uint32_t slot = hash_bytes(key) & index_mask; index[slot]; slot = (slot + 1) & index_mask) {
+    const Record& r = records[index[slot] - 1];
+    if (decoded_key(r, storage) == key)
+      return r.value;
+  }
+  return nullptr;
+}
+
+RValue* JSON::find_symbol(std::string_view symbol) const {
+  // the index hashes decoded keys, which a symbol with escapes is not
+  if (!index || std::memchr(symbol.data(), '\\', symbol.size())) {
+    for (const Record& r : records)
+      if (r.key.lexeme().data() == symbol.data())
+        return r.value;
+    return nullptr;
+  }
+  for (std::uint32_t slot = SymbolTable::hash(symbol) & index_mask; index[slot]; slot = (slot + 1) & index_mask) {
+    const Record& r = records[index[slot] - 1];
+    if (r.key.lexeme().data() == symbol.data())
+      return r.value;
+  }
+  return nullptr;
+}
+
+bool JSON::contains(std::string_view key) const {
+  return find(key) != nullptr;
+}
+
+RValue& RValue::operator[](std::string_view key) {
+  if (type != JSON_TYPE) {
+    Token t = first_token();
+    throw JSONException(SEMANTIC, "value is not an object", t.line(), t.column());
+  }
+  RValue* value = static_cast<JSON*>(this)->find(key);
+  if (!value) {
+    Token t = first_token();
+    throw JSONException(SEMANTIC, "no member '" + std::string(key) + "'", t.line(), t.column());
+  }
+  return *value;
+}
+
 
 // Array
-// cleanup memory
-Array::~Array() {
-  for (RValue* v : values) delete v;
+// Array is always Array type
+Array::Array() {
+  type = ARRAY_TYPE;
 }
 
 // return first token (first primitive value)
@@ -63,6 +153,104 @@ void Array::accept(Visitor& v) {
 
 
 // SimpleRValue
+// the string value with escape sequences decoded (UTF-8)
+std::string SimpleRValue::as_string() const {
+  if (type != STRING_TYPE)
+    throw JSONException(SEMANTIC, "value is not a string", value.line(), value.column());
+  std::string s;
+  unescape_json_string(value.lexeme(), s);
+  return s;
+}
+
+// number cache flags
+static const unsigned char NUMBER_PARSED = 1;
+static const unsigned char NUMBER_NEGATIVE = 2;
+static const unsigned char NUMBER_DOUBLE_PARSED = 4;
+static const int NUMBER_INT_STATUS_SHIFT = 3;    // 2 bits
+static const int NUMBER_DOUBLE_STATUS_SHIFT = 5; // 2 bits
+
+// convert the lexeme to an integer (and to a double if it is not one)
+void SimpleRValue::parse_number() const {
+  if (type != NUMBER_TYPE)
+    throw JSONException(SEMANTIC, "value is not a number", value.line(), value.column());
+  bool negative;
+  std::uint64_t magnitude;
+  double d;
+  NumberStatus double_status;
+  NumberStatus status = parse_json_number(value.lexeme(), negative, magnitude, d, double_status);
+  unsigned char flags = NUMBER_PARSED | (status << NUMBER_INT_STATUS_SHIFT);
+  if (negative) flags |= NUMBER_NEGATIVE;
+  if (status == NUMBER_EXACT) {
+    number_bits = magnitude;
+  } else {
+    std::memcpy(&number_bits, &d, sizeof(d));
+    flags |= NUMBER_DOUBLE_PARSED | (double_status << NUMBER_DOUBLE_STATUS_SHIFT);
+  }
+  number_flags = flags;
+}
+
+NumberStatus SimpleRValue::get_int64(std::int64_t& out) const {
+  if (!number_flags) parse_number();
+  NumberStatus status = static_cast<NumberStatus>((number_flags >> NUMBER_INT_STATUS_SHIFT) & 3);
+  if (status != NUMBER_EXACT) return status;
+  const std::uint64_t max = std::numeric_limits<std::int64_t>::max();
+  if (number_flags & NUMBER_NEGATIVE) {
+    if (number_bits > max + 1) return NUMBER_OVERFLOW;
+    out = number_bits == max + 1
+      ? std::numeric_limits<std::int64_t>::min()
+      : -static_cast<std::int64_t>(number_bits);
+  } else {
+    if (number_bits > max) return NUMBER_OVERFLOW;
+    out = static_cast<std::int64_t>(number_bits);
+  }
+  return NUMBER_EXACT;
+}
+
+NumberStatus SimpleRValue::get_uint64(std::uint64_t& out) const {
+  if (!number_flags) parse_number();
+  NumberStatus status = static_cast<NumberStatus>((number_flags >> NUMBER_INT_STATUS_SHIFT) & 3);
+  if (status != NUMBER_EXACT) return status;
+  if ((number_flags & NUMBER_NEGATIVE) && number_bits) return NUMBER_OVERFLOW;
+  out = number_bits;
+  return NUMBER_EXACT;
+}
+
+NumberStatus SimpleRValue::get_double(double& out) const {
+  if (!number_flags) parse_number();
+  if (!(number_flags & NUMBER_DOUBLE_PARSED))
+    return integer_to_double(number_flags & NUMBER_NEGATIVE, number_bits, out);
+  std::memcpy(&out, &number_bits, sizeof(out));
+  return static_cast<NumberStatus>((number_flags >> NUMBER_DOUBLE_STATUS_SHIFT) & 3);
+}
+
+std::int64_t SimpleRValue::as_int64() const {
+  std::int64_t out;
+  NumberStatus status = get_int64(out);
+  if (status != NUMBER_EXACT)
+    throw JSONException(SEMANTIC, "number '" + std::string(value.lexeme()) +
+      (status == NUMBER_INEXACT ? "' is not an integer" : "' does not fit in int64"),
+      value.line(), value.column());
+  return out;
+}
+
+std::uint64_t SimpleRValue::as_uint64() const {
+  std::uint64_t out;
+  NumberStatus status = get_uint64(out);
+  if (status != NUMBER_EXACT)
+    throw JSONException(SEMANTIC, "number '" + std::string(value.lexeme()) +
+      (status == NUMBER_INEXACT ? "' is not an integer" : "' does not fit in uint64"),
+      value.line(), value.column());
+  return out;
+}
+
+double SimpleRValue::as_double() const {
+  double out;
+  if (get_double(out) == NUMBER_OVERFLOW)
+    throw JSONException(SEMANTIC, "number '" + std::string(value.lexeme()) +
+      "' does not fit in a double", value.line(), value.column());
+  return out;
+}
+
 // return first token
 Token SimpleRValue::first_token() {
   return value;
@@ -1,14 +1,41 @@
 #ifndef AST_H
 #define AST_H
 
-#include <list>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
 #include "token.h"
+#include "arena.h"
+#include "number.h"
 
 enum ValueType {
   STRING_TYPE, NUMBER_TYPE,
   LITERAL_TYPE, ARRAY_TYPE, JSON_TYPE
 };
 
+//----------------------------------------------------------------------
+// Contiguous child storage
+//----------------------------------------------------------------------
+
+// a fixed-size array of child nodes allocated in the document's arena
+template<typename T>
+class NodeSpan
+{
+  public:
+    T* items = nullptr;
+    std::size_t count = 0;
+
+    T* begin() const { return items; }
+    T* end() const { return items + count; }
+    std::size_t size() const { return count; }
+    bool empty() const { return !count; }
+    T& front() const { return items[0]; }
+    T& operator[](std::size_t i) const { return items[i]; }
+};
+
+
 //----------------------------------------------------------------------
 // Visitor interface
 //----------------------------------------------------------------------
@@ -51,6 +78,10 @@ class RValue : public ASTNode
   public:
     ValueType type;
     virtual Token first_token() = 0;
+    // member access on JSON_TYPE values, chainable (doc["a"]["b"]): the
+    // value of key, or a SEMANTIC JSONException if this is not an object
+    // or has no such member (see JSON::find())
+    RValue& operator[](std::string_view key);
 };
 
 
@@ -60,6 +91,8 @@ class Record : public ASTNode
   public:
     Token key;
     RValue* value;
+    // the key with escape sequences decoded (UTF-8)
+    std::string key_string() const;
     // visitor access
     void accept(Visitor&);
 };
@@ -68,7 +101,13 @@ class Record : public ASTNode
 class JSONDocument : public ASTNode
 {
   public:
-    RValue* root;
+    RValue* root = nullptr;
+    // owns every node of the tree (nodes are released together with the
+    // document and are never deleted individually)
+    Arena arena;
+    // keeps the input buffer alive when it is owned by the lexer, since
+    // every token in the tree points into it
+    std::shared_ptr<const void> source;
     void accept(Visitor&);
 };
 
@@ -80,19 +119,46 @@ class JSONDocument : public ASTNode
 
 class JSON : public RValue
 {
+  private:
+    // open-addressing hash table of record index + 1 (0 is empty) for a
+    // large object, built by build_index(). The mask is declared first so
+    // it fits in RValue's tail padding
+    std::uint32_t index_mask = 0;
+    std::uint32_t* index = nullptr;
+
+    void fill_index();
+
   public:
+    // objects with this many members are looked up through a hash index,
+    // smaller ones by a linear scan
+    static const std::size_t INDEX_THRESHOLD = 16;
+
     // JSON is always JSON type
-    ValueType type = JSON_TYPE;
+    JSON();
     // Token of the closing right brace for this object
     Token rbrace_token;
     //  list of declarations
-    std::list<Record*> records;
-    // cleanup memory
-    ~JSON();
+    NodeSpan<Record> records;
     // return first token (first primitive value)
     Token first_token();
     // visitor access
     void accept(Visitor&);
+
+    // the value of the first member named key (compared with escape
+    // sequences decoded), or nullptr
+    RValue* find(std::string_view key) const;
+    bool contains(std::string_view key) const;
+
+    // the same for a document built with a SymbolTable, given a key as
+    // the table stores it (from SymbolTable::intern() or find()): members
+    // match by pointer, through the stored hash, without decoding or
+    // comparing text. Of keys that only decode alike, the first one is
+    // the one found, as with find()
+    RValue* find_symbol(std::string_view symbol) const;
+
+    // build the lookup index in arena, once records is final (nothing is
+    // done for objects below INDEX_THRESHOLD)
+    void build_index(Arena& arena);
 };
 
 
@@ -100,13 +166,11 @@ class Array : public RValue
 {
   public:
     // Array is always Array type
-    ValueType type = ARRAY_TYPE;
+    Array();
     // Token of the closing right bracket for this array
     Token rbracket_token;
     // list of elements
-    std::list<RValue*> values;
-    // cleanup memory
-    ~Array();
+    NodeSpan<RValue*> values;
     // return first token (first primitive value)
     Token first_token();
     // visitor access
@@ -116,9 +180,32 @@ class Array : public RValue
 
 class SimpleRValue : public RValue
 {
+  private:
+    // conversion cache for NUMBER_TYPE values (declared first so the flags
+    // fit in RValue's tail padding). number_bits holds the integer
+    // magnitude if the number is an exact integer, else the double's bits
+    mutable unsigned char number_flags = 0;
+    mutable std::uint64_t number_bits = 0;
+
+    void parse_number() const;
+
   public:
     // primitive value
     Token value;
+    // the string value with escape sequences decoded (UTF-8); decoding
+    // happens on each call, the token keeps the raw lexeme
+    std::string as_string() const;
+
+    // typed access to NUMBER_TYPE values. The lexeme is converted on first
+    // access and cached in the node. The get_ functions report exactness and
+    // overflow; the as_ functions throw a SEMANTIC JSONException unless the
+    // value is an exact integer in range (or, for doubles, in range)
+    NumberStatus get_int64(std::int64_t&) const;
+    NumberStatus get_uint64(std::uint64_t&) const;
+    NumberStatus get_double(double&) const;
+    std::int64_t as_int64() const;
+    std::uint64_t as_uint64() const;
+    double as_double() const;
     // return first token
     Token first_token();
     // visitor access
@@ -126,4 +213,17 @@ class SimpleRValue : public RValue
 };
 
 
+// called for every object the parser builds, so keep the size check inline
+inline void JSON::build_index(Arena& arena)
+{
+  if (records.size() < INDEX_THRESHOLD) return;
+  // a power of two at least twice the member count keeps probes short
+  std::size_t capacity = 1;
+  while (capacity < 2 * records.size()) capacity <<= 1;
+  index = static_cast<std::uint32_t*>(arena.allocate(capacity * sizeof(std::uint32_t), alignof(std::uint32_t)));
+  index_mask = static_cast<std::uint32_t>(capacity - 1);
+  fill_index();
+}
+
+
 #endif // ifndef AST_H
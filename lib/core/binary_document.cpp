@@ -0,0 +1,506 @@
+#ifndef BINARY_DOCUMENT_CPP
+#define BINARY_DOCUMENT_CPP
+
+#include <cstring>
+#include <limits>
+#include "binary_document.h"
+#include "dom_builder.h"
+#include "json_string.h"
+#include "lexer.h"
+#include "parser.h"
+
+
+namespace {
+
+const char MAGIC[4] = {'W', 'J', 'S', 'B'};
+const std::uint32_t VERSION = 1;
+// magic, version, total size
+const std::size_t HEADER_SIZE = 16;
+// tag, count, table offset
+const std::size_t CONTAINER_HEADER_SIZE = 9;
+
+void append_u32(std::string& out, std::uint32_t v)
+{
+  out.append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+void store_u32(std::string& out, std::size_t at, std::uint32_t v)
+{
+  std::memcpy(&out[at], &v, sizeof(v));
+}
+
+std::uint32_t relative(std::size_t offset)
+{
+  if (offset > std::numeric_limits<std::uint32_t>::max())
+    throw JSONException(SEMANTIC, "container too large for the binary format");
+  return static_cast<std::uint32_t>(offset);
+}
+
+[[noreturn]] void damaged()
+{
+  throw JSONException(SYNTAX, "damaged binary document");
+}
+
+[[noreturn]] void type_error(const char* msg)
+{
+  throw JSONException(SEMANTIC, msg);
+}
+
+} // namespace
+
+
+//----------------------------------------------------------------------
+// BinaryWriter
+//----------------------------------------------------------------------
+
+BinaryWriter::BinaryWriter(std::string& output)
+  : out(output), header(std::string::npos), after_key(false)
+{
+}
+
+
+void BinaryWriter::write(JSONDocument& doc)
+{
+  try {
+    node(*doc.root);
+    end_document();
+  } catch (...) {
+    discard();
+    throw;
+  }
+}
+
+
+void BinaryWriter::write(std::string_view json)
+{
+  Lexer lexer(json);
+  Parser parser(lexer);
+  try {
+    parser.parse(*this);
+  } catch (...) {
+    discard();
+    throw;
+  }
+}
+
+
+void BinaryWriter::discard()
+{
+  if (header != std::string::npos) out.resize(header);
+  header = std::string::npos;
+  frames.clear();
+  offsets.clear();
+  after_key = false;
+}
+
+
+void BinaryWriter::node(RValue& value)
+{
+  switch (value.type) {
+    case JSON_TYPE:
+      open('o');
+      for (Record& r : static_cast<JSON&>(value).records) {
+        key(r.key);
+        node(*r.value);
+      }
+      close();
+      break;
+    case ARRAY_TYPE:
+      open('a');
+      for (RValue* element : static_cast<Array&>(value).values)
+        node(*element);
+      close();
+      break;
+    case STRING_TYPE:
+      string_value(static_cast<SimpleRValue&>(value).value);
+      break;
+    case NUMBER_TYPE:
+      number_value(static_cast<SimpleRValue&>(value).value);
+      break;
+    case LITERAL_TYPE:
+      literal_value(static_cast<SimpleRValue&>(value).value);
+      break;
+  }
+}
+
+
+void BinaryWriter::element()
+{
+  if (header == std::string::npos) {
+    header = out.size();
+    out.append(MAGIC, sizeof(MAGIC));
+    append_u32(out, VERSION);
+    out.append(8, '\0');
+  }
+  if (after_key)
+    after_key = false;
+  else if (!frames.empty())
+    offsets.push_back(relative(out.size() - frames.back().start));
+}
+
+
+void BinaryWriter::open(char tag)
+{
+  element();
+  frames.push_back(Frame{out.size(), offsets.size()});
+  out += tag;
+  out.append(8, '\0');
+}
+
+
+void BinaryWriter::close()
+{
+  Frame f = frames.back();
+  frames.pop_back();
+  store_u32(out, f.start + 1, static_cast<std::uint32_t>(offsets.size() - f.first));
+  store_u32(out, f.start + 5, relative(out.size() - f.start));
+  out.append(reinterpret_cast<const char*>(offsets.data() + f.first),
+             (offsets.size() - f.first) * sizeof(std::uint32_t));
+  offsets.resize(f.first);
+}
+
+
+void BinaryWriter::scalar(char tag, std::string_view lexeme)
+{
+  element();
+  out += tag;
+  append_u32(out, relative(lexeme.size()));
+  out.append(lexeme.data(), lexeme.size());
+}
+
+
+void BinaryWriter::start_object(const Token&)
+{
+  open('o');
+}
+
+
+void BinaryWriter::key(const Token& t)
+{
+  element();
+  append_u32(out, relative(t.lexeme().size()));
+  out.append(t.lexeme().data(), t.lexeme().size());
+  after_key = true;
+}
+
+
+void BinaryWriter::end_object(const Token&)
+{
+  close();
+}
+
+
+void BinaryWriter::start_array(const Token&)
+{
+  open('a');
+}
+
+
+void BinaryWriter::end_array(const Token&)
+{
+  close();
+}
+
+
+void BinaryWriter::string_value(const Token& t)
+{
+  scalar('s', t.lexeme());
+}
+
+
+void BinaryWriter::number_value(const Token& t)
+{
+  scalar('n', t.lexeme());
+}
+
+
+void BinaryWriter::literal_value(const Token& t)
+{
+  element();
+  char c = t.lexeme()[0];
+  out += c == 'n' ? 'z' : c;
+}
+
+
+void BinaryWriter::end_document()
+{
+  std::uint64_t size = out.size() - header;
+  std::memcpy(&out[header + 8], &size, sizeof(size));
+  header = std::string::npos;
+}
+
+
+//----------------------------------------------------------------------
+// BinaryValue
+//----------------------------------------------------------------------
+
+BinaryValue::BinaryValue(const char* buffer, std::size_t size, std::size_t at)
+  : base(buffer), length(size), pos(at)
+{
+}
+
+
+char BinaryValue::tag() const
+{
+  if (pos >= length) damaged();
+  return base[pos];
+}
+
+
+std::uint32_t BinaryValue::u32(std::size_t at) const
+{
+  if (at + sizeof(std::uint32_t) > length) damaged();
+  std::uint32_t v;
+  std::memcpy(&v, base + at, sizeof(v));
+  return v;
+}
+
+
+std::string_view BinaryValue::text(std::size_t at) const
+{
+  std::size_t size = u32(at);
+  if (at + 4 + size > length) damaged();
+  return std::string_view(base + at + 4, size);
+}
+
+
+std::size_t BinaryValue::end() const
+{
+  switch (tag()) {
+    case 'o':
+    case 'a': return pos + u32(pos + 5) + 4 * static_cast<std::size_t>(u32(pos + 1));
+    case 's':
+    case 'n': return pos + 5 + text(pos + 1).size();
+    case 't':
+    case 'f':
+    case 'z': return pos + 1;
+    default: damaged();
+  }
+}
+
+
+std::size_t BinaryValue::child_end(std::size_t at) const
+{
+  // a member is its key followed by its value
+  if (tag() == 'o') at += 4 + text(at).size();
+  return BinaryValue(base, length, at).end();
+}
+
+
+std::size_t BinaryValue::child(std::size_t i) const
+{
+  // children follow one another without overlapping and end before the
+  // table, so that every value is reached once (shared children would
+  // make replay() exponential)
+  std::size_t table = pos + u32(pos + 5);
+  std::size_t at = pos + u32(table + 4 * i);
+  std::size_t first = i ? child_end(pos + u32(table + 4 * (i - 1))) : pos + CONTAINER_HEADER_SIZE;
+  if (at < first || child_end(at) > table) damaged();
+  return at;
+}
+
+
+ValueType BinaryValue::type() const
+{
+  switch (tag()) {
+    case 'o': return JSON_TYPE;
+    case 'a': return ARRAY_TYPE;
+    case 's': return STRING_TYPE;
+    case 'n': return NUMBER_TYPE;
+    case 't':
+    case 'f':
+    case 'z': return LITERAL_TYPE;
+    default: damaged();
+  }
+}
+
+
+std::size_t BinaryValue::size() const
+{
+  char t = tag();
+  return t == 'o' || t == 'a' ? u32(pos + 1) : 0;
+}
+
+
+BinaryValue BinaryValue::at(std::size_t i) const
+{
+  if (tag() != 'a') type_error("value is not an array");
+  if (i >= size()) type_error("index is out of range");
+  return BinaryValue(base, length, child(i));
+}
+
+
+std::string_view BinaryValue::key(std::size_t i) const
+{
+  if (tag() != 'o') type_error("value is not an object");
+  if (i >= size()) type_error("index is out of range");
+  return text(child(i));
+}
+
+
+BinaryValue BinaryValue::value(std::size_t i) const
+{
+  std::string_view k = key(i);
+  return BinaryValue(base, length, k.data() + k.size() - base);
+}
+
+
+bool BinaryValue::find(std::string_view name, BinaryValue& found) const
+{
+  if (tag() != 'o') type_error("value is not an object");
+  for (std::size_t i = 0, n = size(); i < n; ++i) {
+    std::string_view k = text(child(i));
+    if (json_string_equals(k, name)) {
+      found = BinaryValue(base, length, k.data() + k.size() - base);
+      return true;
+    }
+  }
+  return false;
+}
+
+
+BinaryValue BinaryValue::operator[](std::string_view name) const
+{
+  BinaryValue found;
+  if (!find(name, found))
+    throw JSONException(SEMANTIC, "no member '" + std::string(name) + "'");
+  return found;
+}
+
+
+std::string_view BinaryValue::lexeme() const
+{
+  switch (tag()) {
+    case 's':
+    case 'n': return text(pos + 1);
+    case 't': return "true";
+    case 'f': return "false";
+    case 'z': return "null";
+    default: type_error("value is not a scalar");
+  }
+}
+
+
+SimpleRValue BinaryValue::scalar() const
+{
+  std::string_view l = lexeme();
+  SimpleRValue node;
+  node.type = type();
+  TokenType t = node.type == STRING_TYPE ? STRING_VAL : node.type == NUMBER_TYPE ? NUMBER_VAL : LITERAL_VAL;
+  node.value = Token(t, l, 0, 0);
+  return node;
+}
+
+
+std::string BinaryValue::as_string() const
+{
+  if (tag() != 's') type_error("value is not a string");
+  return scalar().as_string();
+}
+
+
+std::int64_t BinaryValue::as_int64() const
+{
+  if (tag() != 'n') type_error("value is not a number");
+  return scalar().as_int64();
+}
+
+
+std::uint64_t BinaryValue::as_uint64() const
+{
+  if (tag() != 'n') type_error("value is not a number");
+  return scalar().as_uint64();
+}
+
+
+double BinaryValue::as_double() const
+{
+  if (tag() != 'n') type_error("value is not a number");
+  return scalar().as_double();
+}
+
+
+void BinaryValue::replay(Handler& handler) const
+{
+  replay(handler, 0);
+}
+
+
+void BinaryValue::replay(Handler& handler, std::size_t depth) const
+{
+  char t = tag();
+  if ((t == 'o' || t == 'a') && depth >= Parser::DEFAULT_MAX_DEPTH)
+    throw JSONException(SYNTAX, "Maximum nesting depth of " + std::to_string(Parser::DEFAULT_MAX_DEPTH) + " exceeded");
+  switch (t) {
+    case 'o':
+      handler.start_object(Token(LBRACE, "{", 0, 0));
+      for (std::size_t i = 0, n = size(); i < n; ++i) {
+        std::string_view k = text(child(i));
+        handler.key(Token(STRING_VAL, k, 0, 0));
+        BinaryValue(base, length, k.data() + k.size() - base).replay(handler, depth + 1);
+      }
+      handler.end_object(Token(RBRACE, "}", 0, 0));
+      break;
+    case 'a':
+      handler.start_array(Token(LBRACKET, "[", 0, 0));
+      for (std::size_t i = 0, n = size(); i < n; ++i)
+        BinaryValue(base, length, child(i)).replay(handler, depth + 1);
+      handler.end_array(Token(RBRACKET, "]", 0, 0));
+      break;
+    case 's':
+      handler.string_value(Token(STRING_VAL, lexeme(), 0, 0));
+      break;
+    case 'n':
+      handler.number_value(Token(NUMBER_VAL, lexeme(), 0, 0));
+      break;
+    case 't':
+    case 'f':
+    case 'z':
+      handler.literal_value(Token(LITERAL_VAL, lexeme(), 0, 0));
+      break;
+    default:
+      damaged();
+  }
+}
+
+
+//----------------------------------------------------------------------
+// BinaryDocument
+//----------------------------------------------------------------------
+
+bool BinaryDocument::is_binary(std::string_view bytes)
+{
+  return bytes.size() >= sizeof(MAGIC) && !std::memcmp(bytes.data(), MAGIC, sizeof(MAGIC));
+}
+
+
+BinaryDocument::BinaryDocument(std::string_view input)
+{
+  std::uint32_t version;
+  std::uint64_t size;
+  if (input.size() < HEADER_SIZE || !is_binary(input))
+    throw JSONException(SYNTAX, "not a binary document");
+  std::memcpy(&version, input.data() + 4, sizeof(version));
+  std::memcpy(&size, input.data() + 8, sizeof(size));
+  if (version != VERSION)
+    throw JSONException(SYNTAX, "unsupported binary document version " + std::to_string(version));
+  if (size < HEADER_SIZE + 1 || size > input.size())
+    damaged();
+  bytes = input.substr(0, size);
+}
+
+
+BinaryValue BinaryDocument::root() const
+{
+  return BinaryValue(bytes.data(), bytes.size(), HEADER_SIZE);
+}
+
+
+void BinaryDocument::parse(JSONDocument& doc) const
+{
+  DOMBuilder builder(doc, false);
+  root().replay(builder);
+}
+
+
+#endif // ifndef BINARY_DOCUMENT_CPP
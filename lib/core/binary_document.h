@@ -0,0 +1,177 @@
+#ifndef BINARY_DOCUMENT_H
+#define BINARY_DOCUMENT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "token.h"
+#include "json_exception.h"
+#include "handler.h"
+#include "ast.h"
+
+
+//----------------------------------------------------------------------
+// Binary encoding of a document
+//----------------------------------------------------------------------
+
+// A 16-byte header ("WJSB", a version and the total size) and the root
+// value. Every value starts with a one-byte tag:
+//
+//   'o' object: u32 member count, u32 table offset, the members (each a
+//       key followed directly by its value), then the table: the offset
+//       of every member's key
+//   'a' array:  u32 element count, u32 table offset, the elements, then
+//       the offset of every element
+//   's' string, 'n' number: u32 length, then the lexeme (strings with
+//       their escapes as written, without quotes)
+//   't' true, 'f' false, 'z' null
+//
+// Offsets are from the start of the container and keys are u32 length
+// plus lexeme. Integers are u32/u64 in native byte order, unaligned (a
+// document from the other byte order has the magic but fails the
+// version check). Since lexemes are kept as written, a document converts
+// back to exactly the compact Printer output, and a container is read in
+// place: element i and member i are found through the table without
+// looking at the others.
+
+
+// Writes documents in the binary encoding, from a tree or straight from
+// parser events (Parser::parse(Handler&)), appending to a string.
+class BinaryWriter final : public Handler
+{
+  public:
+    explicit BinaryWriter(std::string& out);
+
+    // append one encoded document
+    void write(JSONDocument& doc);
+    // encode JSON text without building a tree (throws JSONException)
+    void write(std::string_view json);
+
+    // events: a document is the events of one value, then end_document()
+    void start_object(const Token&) override;
+    void key(const Token&) override;
+    void end_object(const Token&) override;
+    void start_array(const Token&) override;
+    void end_array(const Token&) override;
+    void string_value(const Token&) override;
+    void number_value(const Token&) override;
+    void literal_value(const Token&) override;
+    void end_document() override;
+
+  private:
+    std::string& out;
+    // where the current document's header starts, or npos before its
+    // first event
+    std::size_t header;
+    // open containers: where each starts and where its children's
+    // offsets start in offsets
+    struct Frame
+    {
+      std::size_t start;
+      std::size_t first;
+    };
+    std::vector<Frame> frames;
+    std::vector<std::uint32_t> offsets;
+    // the next value is a member's value, recorded with its key
+    bool after_key;
+
+    // drop a partial document and start over (after an exception)
+    void discard();
+    // header and child offset before a value or key
+    void element();
+    void open(char tag);
+    void close();
+    void scalar(char tag, std::string_view lexeme);
+    void node(RValue& value);
+};
+
+
+// An encoded value read in place. Accessors check every offset against
+// the buffer and throw a SYNTAX JSONException (without a position) on a
+// damaged document; type errors are SEMANTIC JSONExceptions, as in the
+// tree.
+class BinaryValue
+{
+  public:
+    // no value, to be filled by find()
+    BinaryValue() = default;
+
+    ValueType type() const;
+
+    // number of elements or members (0 for scalars)
+    std::size_t size() const;
+
+    // element i of an array
+    BinaryValue at(std::size_t i) const;
+
+    // member i of an object: its key lexeme and its value
+    std::string_view key(std::size_t i) const;
+    BinaryValue value(std::size_t i) const;
+
+    // the value of the first member named key (compared with escape
+    // sequences decoded), or false
+    bool find(std::string_view key, BinaryValue& value) const;
+    // the same, chainable, throwing if there is no such member
+    BinaryValue operator[](std::string_view key) const;
+
+    // the lexeme of a scalar
+    std::string_view lexeme() const;
+
+    // the value as a detached node, for the conversions of SimpleRValue
+    SimpleRValue scalar() const;
+    std::string as_string() const;
+    std::int64_t as_int64() const;
+    std::uint64_t as_uint64() const;
+    double as_double() const;
+
+    // report the value to handler as Parser::parse(Handler&) would
+    // (tokens point into the buffer and have no line or column)
+    void replay(Handler& handler) const;
+
+  private:
+    const char* base = nullptr;
+    std::size_t length = 0;
+    std::size_t pos = 0;
+
+    BinaryValue(const char* base, std::size_t length, std::size_t pos);
+    char tag() const;
+    std::uint32_t u32(std::size_t at) const;
+    // where the value ends
+    std::size_t end() const;
+    // where the child (an element, or a member's key) at at ends
+    std::size_t child_end(std::size_t at) const;
+    // the offset of child i of a container (checked against its
+    // neighbours and the table)
+    std::size_t child(std::size_t i) const;
+    std::string_view text(std::size_t at) const;
+    void replay(Handler& handler, std::size_t depth) const;
+
+    friend class BinaryDocument;
+};
+
+
+// An encoded document over a buffer (e.g. a MappedFile), which must
+// outlive it and every value and tree read from it.
+class BinaryDocument
+{
+  public:
+    // whether bytes start with the binary header
+    static bool is_binary(std::string_view bytes);
+
+    // check the header (a SYNTAX JSONException if it is not a complete
+    // binary document)
+    explicit BinaryDocument(std::string_view bytes);
+
+    BinaryValue root() const;
+
+    // build the tree (tokens point into the buffer)
+    void parse(JSONDocument& doc) const;
+
+  private:
+    std::string_view bytes;
+};
+
+
+#endif // ifndef BINARY_DOCUMENT_H
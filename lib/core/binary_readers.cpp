@@ -0,0 +1,462 @@
+#ifndef BINARY_READERS_CPP
+#define BINARY_READERS_CPP
+
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include "binary_readers.h"
+#include "dom_builder.h"
+#include "json_string.h"
+#include "parser.h"
+
+
+namespace {
+
+// one decoded data item: a scalar as a JSON lexeme, the head of a
+// container, or the end of an indefinite-length container
+struct Item
+{
+  enum Kind { SCALAR, ARRAY, MAP, BREAK };
+  Kind kind;
+  TokenType token;
+  std::string_view text;
+  std::uint64_t count;
+  bool indefinite;
+};
+
+
+[[noreturn]] void malformed(const std::string& msg, std::size_t offset)
+{
+  throw JSONException(SYNTAX, msg + " at byte " + std::to_string(offset));
+}
+
+
+// shared by the formats: bytes, numbers and text as JSON lexemes
+class Decoder
+{
+  public:
+    Decoder(std::string_view input, std::string& scratch)
+      : begin(reinterpret_cast<const unsigned char*>(input.data())),
+        p(begin), end(begin + input.size()), out(scratch)
+    {
+    }
+
+    bool at_end() const { return p == end; }
+    std::size_t offset() const { return p - begin; }
+
+  protected:
+    const unsigned char* begin;
+    const unsigned char* p;
+    const unsigned char* end;
+    std::string& out;
+    // the start of the item being decoded
+    std::size_t item_offset = 0;
+
+    void need(std::uint64_t n)
+    {
+      if (static_cast<std::uint64_t>(end - p) < n)
+        malformed("Unexpected end of input", item_offset);
+    }
+
+    // big-endian unsigned integer of n bytes
+    std::uint64_t big_endian(int n)
+    {
+      need(n);
+      std::uint64_t v = 0;
+      for (int i = 0; i < n; ++i)
+        v = (v << 8) | *p++;
+      return v;
+    }
+
+    std::string_view bytes(std::uint64_t n)
+    {
+      need(n);
+      std::string_view s(reinterpret_cast<const char*>(p), n);
+      p += n;
+      return s;
+    }
+
+    static Item scalar(TokenType token, std::string_view text)
+    {
+      return Item{Item::SCALAR, token, text, 0, false};
+    }
+
+    static Item container(Item::Kind kind, std::uint64_t count, bool indefinite)
+    {
+      return Item{kind, EOS, std::string_view(), count, indefinite};
+    }
+
+    Item text(std::string_view utf8)
+    {
+      out.clear();
+      escape_json_string(utf8, out);
+      return scalar(STRING_VAL, out);
+    }
+
+    // unpadded base64url (RFC 8949 section 6.1)
+    Item base64url(std::string_view data)
+    {
+      static const char alphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+      out.clear();
+      const unsigned char* s = reinterpret_cast<const unsigned char*>(data.data());
+      std::size_t n = data.size(), i = 0;
+      for (; i + 3 <= n; i += 3) {
+        unsigned int v = (s[i] << 16) | (s[i + 1] << 8) | s[i + 2];
+        out += alphabet[v >> 18];
+        out += alphabet[(v >> 12) & 63];
+        out += alphabet[(v >> 6) & 63];
+        out += alphabet[v & 63];
+      }
+      if (i + 1 == n) {
+        out += alphabet[s[i] >> 2];
+        out += alphabet[(s[i] & 3) << 4];
+      } else if (i + 2 == n) {
+        unsigned int v = (s[i] << 8) | s[i + 1];
+        out += alphabet[v >> 10];
+        out += alphabet[(v >> 4) & 63];
+        out += alphabet[(v & 15) << 2];
+      }
+      return scalar(STRING_VAL, out);
+    }
+
+    Item unsigned_number(std::uint64_t v)
+    {
+      char buf[24];
+      out.assign(buf, std::to_chars(buf, buf + sizeof(buf), v).ptr);
+      return scalar(NUMBER_VAL, out);
+    }
+
+    Item signed_number(std::int64_t v)
+    {
+      char buf[24];
+      out.assign(buf, std::to_chars(buf, buf + sizeof(buf), v).ptr);
+      return scalar(NUMBER_VAL, out);
+    }
+
+    // -1 - v, which may be below the int64 range
+    Item negative_number(std::uint64_t v)
+    {
+      out.assign(1, '-');
+      if (v == UINT64_MAX) {
+        out += "18446744073709551616";
+      } else {
+        char buf[24];
+        out.append(buf, std::to_chars(buf, buf + sizeof(buf), v + 1).ptr);
+      }
+      return scalar(NUMBER_VAL, out);
+    }
+
+    // shortest round-trip text of the float type that was encoded
+    template<typename F>
+    Item floating(F v)
+    {
+      if (!std::isfinite(v))
+        return scalar(LITERAL_VAL, "null");
+      char buf[32];
+      out.assign(buf, std::to_chars(buf, buf + sizeof(buf), v).ptr);
+      return scalar(NUMBER_VAL, out);
+    }
+};
+
+
+class CBORDecoder : public Decoder
+{
+  public:
+    CBORDecoder(std::string_view input, std::string& scratch, std::string& chunk_buffer)
+      : Decoder(input, scratch), chunks(chunk_buffer)
+    {
+    }
+
+    Item next()
+    {
+      while (1) {
+        item_offset = offset();
+        need(1);
+        unsigned int major = *p >> 5;
+        unsigned int info = *p++ & 31;
+        if (info == 31) {
+          switch (major) {
+            case 2:
+            case 3:
+              return chunked(major);
+            case 4:
+              return container(Item::ARRAY, 0, true);
+            case 5:
+              return container(Item::MAP, 0, true);
+            case 7:
+              return container(Item::BREAK, 0, false);
+            default:
+              malformed("Invalid indefinite length", item_offset);
+          }
+        }
+        std::uint64_t arg = argument(info);
+        switch (major) {
+          case 0:
+            return unsigned_number(arg);
+          case 1:
+            return negative_number(arg);
+          case 2:
+            return base64url(bytes(arg));
+          case 3:
+            return text(bytes(arg));
+          case 4:
+            return container(Item::ARRAY, arg, false);
+          case 5:
+            return container(Item::MAP, arg, false);
+          case 6:
+            // a tag: the tagged item stands for itself
+            continue;
+          default:
+            return simple(info, arg);
+        }
+      }
+    }
+
+  private:
+    std::string& chunks;
+
+    std::uint64_t argument(unsigned int info)
+    {
+      if (info < 24) return info;
+      switch (info) {
+        case 24: return big_endian(1);
+        case 25: return big_endian(2);
+        case 26: return big_endian(4);
+        case 27: return big_endian(8);
+        default: malformed("Invalid additional information", item_offset);
+      }
+    }
+
+    // the chunks of an indefinite-length string up to the break
+    Item chunked(unsigned int major)
+    {
+      std::size_t start = item_offset;
+      chunks.clear();
+      while (1) {
+        need(1);
+        if (*p == 0xff) {
+          ++p;
+          break;
+        }
+        item_offset = offset();
+        unsigned int info = *p & 31;
+        if ((*p >> 5) != major || info == 31)
+          malformed("Invalid chunk of an indefinite-length string", item_offset);
+        ++p;
+        std::string_view chunk = bytes(argument(info));
+        chunks.append(chunk.data(), chunk.size());
+      }
+      item_offset = start;
+      return major == 2 ? base64url(chunks) : text(chunks);
+    }
+
+    Item simple(unsigned int info, std::uint64_t arg)
+    {
+      switch (info) {
+        case 20: return scalar(LITERAL_VAL, "false");
+        case 21: return scalar(LITERAL_VAL, "true");
+        case 22:
+        case 23: return scalar(LITERAL_VAL, "null");
+        case 25: return floating(half_to_float(static_cast<std::uint16_t>(arg)));
+        case 26: {
+          std::uint32_t bits = static_cast<std::uint32_t>(arg);
+          float f;
+          std::memcpy(&f, &bits, sizeof(f));
+          return floating(f);
+        }
+        case 27: {
+          double d;
+          std::memcpy(&d, &arg, sizeof(d));
+          return floating(d);
+        }
+        default:
+          malformed("Simple value has no JSON equivalent", item_offset);
+      }
+    }
+
+    static float half_to_float(std::uint16_t h)
+    {
+      int exponent = (h >> 10) & 0x1f;
+      int mantissa = h & 0x3ff;
+      float v;
+      if (exponent == 0)
+        v = std::ldexp(static_cast<float>(mantissa), -24);
+      else if (exponent != 31)
+        v = std::ldexp(static_cast<float>(mantissa + 1024), exponent - 25);
+      else
+        v = mantissa ? NAN : INFINITY;
+      return h & 0x8000 ? -v : v;
+    }
+};
+
+
+class MessagePackDecoder : public Decoder
+{
+  public:
+    using Decoder::Decoder;
+
+    Item next()
+    {
+      item_offset = offset();
+      need(1);
+      unsigned int b = *p++;
+      if (b <= 0x7f) return unsigned_number(b);
+      if (b <= 0x8f) return container(Item::MAP, b & 0x0f, false);
+      if (b <= 0x9f) return container(Item::ARRAY, b & 0x0f, false);
+      if (b <= 0xbf) return text(bytes(b & 0x1f));
+      if (b >= 0xe0) return signed_number(static_cast<std::int8_t>(b));
+      switch (b) {
+        case 0xc0: return scalar(LITERAL_VAL, "null");
+        case 0xc2: return scalar(LITERAL_VAL, "false");
+        case 0xc3: return scalar(LITERAL_VAL, "true");
+        case 0xc4: return base64url(bytes(big_endian(1)));
+        case 0xc5: return base64url(bytes(big_endian(2)));
+        case 0xc6: return base64url(bytes(big_endian(4)));
+        case 0xca: {
+          std::uint32_t bits = static_cast<std::uint32_t>(big_endian(4));
+          float f;
+          std::memcpy(&f, &bits, sizeof(f));
+          return floating(f);
+        }
+        case 0xcb: {
+          std::uint64_t bits = big_endian(8);
+          double d;
+          std::memcpy(&d, &bits, sizeof(d));
+          return floating(d);
+        }
+        case 0xcc: return unsigned_number(big_endian(1));
+        case 0xcd: return unsigned_number(big_endian(2));
+        case 0xce: return unsigned_number(big_endian(4));
+        case 0xcf: return unsigned_number(big_endian(8));
+        case 0xd0: return signed_number(static_cast<std::int8_t>(big_endian(1)));
+        case 0xd1: return signed_number(static_cast<std::int16_t>(big_endian(2)));
+        case 0xd2: return signed_number(static_cast<std::int32_t>(big_endian(4)));
+        case 0xd3: return signed_number(static_cast<std::int64_t>(big_endian(8)));
+        case 0xd9: return text(bytes(big_endian(1)));
+        case 0xda: return text(bytes(big_endian(2)));
+        case 0xdb: return text(bytes(big_endian(4)));
+        case 0xdc: return container(Item::ARRAY, big_endian(2), false);
+        case 0xdd: return container(Item::ARRAY, big_endian(4), false);
+        case 0xde: return container(Item::MAP, big_endian(2), false);
+        case 0xdf: return container(Item::MAP, big_endian(4), false);
+        case 0xc1: malformed("Invalid type byte", item_offset);
+        default: malformed("Extension type has no JSON equivalent", item_offset);
+      }
+    }
+};
+
+
+// an open container: items still to come (values only, for maps) unless
+// it ends with a break
+struct Frame
+{
+  bool map;
+  bool indefinite;
+  std::uint64_t remaining;
+};
+
+// report one data item, turning the decoder's items into handler events
+// with an explicit stack of open containers
+template<typename D>
+void report(D& decoder, Handler& handler)
+{
+  std::vector<Frame> frames;
+  bool want_key = false;
+  do {
+    std::size_t offset = decoder.offset();
+    Item item = decoder.next();
+    bool done = false;
+    if (item.kind == Item::BREAK) {
+      if (frames.empty() || !frames.back().indefinite || (frames.back().map && !want_key))
+        malformed("Unexpected break", offset);
+      if (frames.back().map)
+        handler.end_object(Token(RBRACE, "}", 0, 0));
+      else
+        handler.end_array(Token(RBRACKET, "]", 0, 0));
+      frames.pop_back();
+      done = true;
+    } else if (want_key) {
+      if (item.kind != Item::SCALAR || item.token == LITERAL_VAL)
+        malformed("Map key has no JSON equivalent", offset);
+      handler.key(Token(STRING_VAL, item.text, 0, 0));
+      want_key = false;
+    } else if (item.kind == Item::SCALAR) {
+      Token t(item.token, item.text, 0, 0);
+      if (item.token == STRING_VAL)
+        handler.string_value(t);
+      else if (item.token == NUMBER_VAL)
+        handler.number_value(t);
+      else
+        handler.literal_value(t);
+      done = true;
+    } else {
+      if (frames.size() >= Parser::DEFAULT_MAX_DEPTH)
+        malformed("Maximum nesting depth of " + std::to_string(Parser::DEFAULT_MAX_DEPTH) + " exceeded", offset);
+      bool map = item.kind == Item::MAP;
+      if (map)
+        handler.start_object(Token(LBRACE, "{", 0, 0));
+      else
+        handler.start_array(Token(LBRACKET, "[", 0, 0));
+      if (item.indefinite || item.count) {
+        frames.push_back(Frame{map, item.indefinite, item.count});
+        want_key = map;
+      } else {
+        if (map)
+          handler.end_object(Token(RBRACE, "}", 0, 0));
+        else
+          handler.end_array(Token(RBRACKET, "]", 0, 0));
+        done = true;
+      }
+    }
+    // a value is complete: count it, closing every container it fills
+    while (done && !frames.empty()) {
+      Frame& f = frames.back();
+      if (f.indefinite || --f.remaining) {
+        want_key = f.map;
+        break;
+      }
+      if (f.map)
+        handler.end_object(Token(RBRACE, "}", 0, 0));
+      else
+        handler.end_array(Token(RBRACKET, "]", 0, 0));
+      frames.pop_back();
+    }
+  } while (!frames.empty());
+  if (!decoder.at_end())
+    malformed("Unexpected data after the end of the item", decoder.offset());
+  handler.end_document();
+}
+
+} // namespace
+
+
+void CBORReader::parse(std::string_view input, Handler& handler)
+{
+  CBORDecoder decoder(input, scratch, chunks);
+  report(decoder, handler);
+}
+
+
+void CBORReader::parse(std::string_view input, JSONDocument& doc)
+{
+  DOMBuilder builder(doc, true);
+  parse(input, builder);
+}
+
+
+void MessagePackReader::parse(std::string_view input, Handler& handler)
+{
+  MessagePackDecoder decoder(input, scratch);
+  report(decoder, handler);
+}
+
+
+void MessagePackReader::parse(std::string_view input, JSONDocument& doc)
+{
+  DOMBuilder builder(doc, true);
+  parse(input, builder);
+}
+
+
+#endif // ifndef BINARY_READERS_CPP
@@ -0,0 +1,58 @@
+#ifndef BINARY_READERS_H
+#define BINARY_READERS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "json_exception.h"
+#include "handler.h"
+#include "ast.h"
+
+
+//----------------------------------------------------------------------
+// CBOR and MessagePack input
+//----------------------------------------------------------------------
+
+// Both readers decode exactly one data item and report it as the same
+// events Parser::parse(Handler&) produces, or build the same tree, so
+// everything downstream of the parser (DOMBuilder, Minifier, the
+// printers) works on them unchanged. Values become JSON lexemes on the
+// way, following RFC 8949 section 6.1: text is escaped as in
+// escape_json_string() (its UTF-8 is not checked), integers keep every
+// digit, floats are written in their shortest round-trip form (NaN and
+// infinities as null), byte strings as unpadded base64url text, tags are
+// dropped, and integer map keys become their decimal text. Tokens have no line or column, and a
+// lexeme is only valid during its event. Malformed input throws a SYNTAX
+// JSONException naming the byte offset; containers nest at most
+// Parser::DEFAULT_MAX_DEPTH deep.
+
+// RFC 8949 Concise Binary Object Representation (definite and indefinite
+// lengths, half/single/double floats)
+class CBORReader
+{
+  public:
+    void parse(std::string_view input, Handler& handler);
+    void parse(std::string_view input, JSONDocument& doc);
+
+  private:
+    // decoded lexemes and chunked strings, reused between items
+    std::string scratch;
+    std::string chunks;
+};
+
+
+// MessagePack (extension types have no JSON equivalent and are rejected)
+class MessagePackReader
+{
+  public:
+    void parse(std::string_view input, Handler& handler);
+    void parse(std::string_view input, JSONDocument& doc);
+
+  private:
+    std::string scratch;
+};
+
+
+#endif // ifndef BINARY_READERS_H
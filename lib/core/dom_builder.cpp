@@ -0,0 +1,13 @@
+#ifndef DOM_BUILDER_CPP
+#define DOM_BUILDER_CPP
+
+#include "dom_builder.h"
+
+
+DOMBuilder::DOMBuilder(JSONDocument& document, bool copy, SymbolTable* symbol_table)
+  : doc(document), copy_lexemes(copy), symbols(symbol_table), in_object(false)
+{
+}
+
+
+#endif // ifndef DOM_BUILDER_CPP
@@ -0,0 +1,172 @@
+#ifndef DOM_BUILDER_H
+#define DOM_BUILDER_H
+
+#include <cstddef>
+#include <vector>
+#include "handler.h"
+#include "ast.h"
+#include "symbol_table.h"
+
+
+//----------------------------------------------------------------------
+// Handler that builds a JSONDocument
+//----------------------------------------------------------------------
+
+class DOMBuilder final : public Handler
+{
+  public:
+    // build the tree into doc. With copy_lexemes every lexeme is copied
+    // into the document's arena, which is required when the tokens do not
+    // outlive the parse (see Lexer::stable_tokens()). With symbols, keys
+    // point at their interned copy instead
+    DOMBuilder(JSONDocument& doc, bool copy_lexemes, SymbolTable* symbols = nullptr);
+
+    void start_object(const Token&) override;
+    void key(const Token&) override;
+    void end_object(const Token&) override;
+    void start_array(const Token&) override;
+    void end_array(const Token&) override;
+    void string_value(const Token&) override;
+    void number_value(const Token&) override;
+    void literal_value(const Token&) override;
+
+  private:
+    // an open container, the key it will be stored under (objects only)
+    // and where its children start on the stacks below
+    struct Frame
+    {
+      RValue* node;
+      Token key;
+      std::size_t first;
+    };
+
+    JSONDocument& doc;
+    bool copy_lexemes;
+    SymbolTable* symbols;
+    Token pending_key;
+    std::vector<Frame> frames;
+    // whether the innermost open container is an object
+    bool in_object;
+
+    // children of the open containers; each container collects its
+    // children on top of these and copies them into one contiguous arena
+    // array when it closes
+    std::vector<Record> record_stack;
+    std::vector<RValue*> value_stack;
+
+    // the token, with its lexeme moved into the arena if required
+    Token keep(const Token&);
+
+    // add a finished value to the innermost open container (or make it
+    // the root)
+    void attach(RValue* node, const Token& key);
+
+    void scalar(const Token&, ValueType);
+};
+
+
+// the parser calls these once per token, so keep them inline
+inline Token DOMBuilder::keep(const Token& t)
+{
+  if (!copy_lexemes) return t;
+  std::string_view lexeme = t.lexeme();
+  const char* copy = doc.arena.copy_array(lexeme.data(), lexeme.size());
+  return Token(t.type(), std::string_view(copy, lexeme.size()), t.line(), t.column());
+}
+
+
+inline void DOMBuilder::attach(RValue* node, const Token& key)
+{
+  if (frames.empty()) {
+    doc.root = node;
+  } else if (in_object) {
+    Record r;
+    r.key = key;
+    r.value = node;
+    record_stack.push_back(r);
+  } else {
+    value_stack.push_back(node);
+  }
+}
+
+
+inline void DOMBuilder::start_object(const Token&)
+{
+  frames.push_back(Frame{doc.arena.create<JSON>(), pending_key, record_stack.size()});
+  in_object = true;
+}
+
+
+inline void DOMBuilder::key(const Token& t)
+{
+  if (symbols)
+    pending_key = Token(t.type(), symbols->intern(t.lexeme()), t.line(), t.column());
+  else
+    pending_key = keep(t);
+}
+
+
+inline void DOMBuilder::end_object(const Token& rbrace)
+{
+  Frame f = frames.back();
+  frames.pop_back();
+  in_object = !frames.empty() && frames.back().node->type == JSON_TYPE;
+  JSON* node = static_cast<JSON*>(f.node);
+  node->rbrace_token = keep(rbrace);
+  node->records.count = record_stack.size() - f.first;
+  node->records.items = doc.arena.copy_array(record_stack.data() + f.first, node->records.count);
+  node->build_index(doc.arena);
+  record_stack.resize(f.first);
+  attach(node, f.key);
+}
+
+
+inline void DOMBuilder::start_array(const Token&)
+{
+  frames.push_back(Frame{doc.arena.create<Array>(), pending_key, value_stack.size()});
+  in_object = false;
+}
+
+
+inline void DOMBuilder::end_array(const Token& rbracket)
+{
+  Frame f = frames.back();
+  frames.pop_back();
+  in_object = !frames.empty() && frames.back().node->type == JSON_TYPE;
+  Array* node = static_cast<Array*>(f.node);
+  node->rbracket_token = keep(rbracket);
+  node->values.count = value_stack.size() - f.first;
+  node->values.items = doc.arena.copy_array(value_stack.data() + f.first, node->values.count);
+  value_stack.resize(f.first);
+  attach(node, f.key);
+}
+
+
+inline void DOMBuilder::scalar(const Token& t, ValueType type)
+{
+  SimpleRValue* node = doc.arena.create<SimpleRValue>();
+  node->value = keep(t);
+  node->type = type;
+  attach(node, pending_key);
+}
+
+
+inline void DOMBuilder::string_value(const Token& t)
+{
+  scalar(t, STRING_TYPE);
+}
+
+
+inline void DOMBuilder::number_value(const Token& t)
+{
+  scalar(t, NUMBER_TYPE);
+}
+
+
+inline void DOMBuilder::literal_value(const Token& t)
+{
+  scalar(t, LITERAL_TYPE);
+}
+
+
+#endif // ifndef DOM_BUILDER_H
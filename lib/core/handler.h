@@ -0,0 +1,38 @@
+#ifndef HANDLER_H
+#define HANDLER_H
+
+#include "token.h"
+
+
+//----------------------------------------------------------------------
+// Event (SAX) interface to the parser
+//----------------------------------------------------------------------
+
+// Parser::parse(Handler&) reports the document as a sequence of events in
+// document order instead of building a tree. Every event carries the token
+// that caused it; its lexeme is only guaranteed valid during the call
+// (streaming lexers reuse their buffer), so handlers copy what they keep.
+// Object members arrive as key() followed by the member's value events.
+class Handler
+{
+  public:
+    virtual ~Handler() {}
+
+    virtual void start_object(const Token& lbrace) = 0;
+    virtual void key(const Token& key) = 0;
+    virtual void end_object(const Token& rbrace) = 0;
+
+    virtual void start_array(const Token& lbracket) = 0;
+    virtual void end_array(const Token& rbracket) = 0;
+
+    // scalar values (strings without their quotes, escapes not decoded)
+    virtual void string_value(const Token& value) = 0;
+    virtual void number_value(const Token& value) = 0;
+    virtual void literal_value(const Token& value) = 0;
+
+    // the whole input has been consumed
+    virtual void end_document() {}
+};
+
+
+#endif // ifndef HANDLER_H
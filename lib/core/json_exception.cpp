@@ -32,4 +32,12 @@ std::string JSONException::to_string() const
 }
 
 
+JSONException JSONException::at_line(int l) const
+{
+  if (!has_line_column)
+    return *this;
+  return JSONException(type, message, l, column);
+}
+
+
 #endif // ifndef JSON_EXCEPTION_CPP
@@ -21,6 +21,10 @@ class JSONException : public std::exception
   // return a string representation for printing
   std::string to_string() const;
 
+  // the same error at another line (for an error found in one line of a
+  // larger input)
+  JSONException at_line(int line) const;
+
  private:
 
   ExceptionType type;
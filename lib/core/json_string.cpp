@@ -0,0 +1,234 @@
+#ifndef JSON_STRING_CPP
+#define JSON_STRING_CPP
+
+#include <cstring>
+#include "json_string.h"
+#include "lexer.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define WJSON_SSE2 1
+#include <emmintrin.h>
+#endif
+
+
+namespace {
+
+inline int first_set_bit(unsigned int mask)
+{
+#if defined(__GNUC__)
+  return __builtin_ctz(mask);
+#else
+  int n = 0;
+  while (!(mask & 1)) { mask >>= 1; ++n; }
+  return n;
+#endif
+}
+
+inline int hex_value(char c)
+{
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+// value of the 4 hex digits at p (already validated)
+inline unsigned int read_hex4(const char* p)
+{
+  return (hex_value(p[0]) << 12) | (hex_value(p[1]) << 8) |
+    (hex_value(p[2]) << 4) | hex_value(p[3]);
+}
+
+void append_utf8(unsigned int cp, std::string& out)
+{
+  if (cp < 0x80) {
+    out += static_cast<char>(cp);
+  } else if (cp < 0x800) {
+    out += static_cast<char>(0xC0 | (cp >> 6));
+    out += static_cast<char>(0x80 | (cp & 0x3F));
+  } else if (cp < 0x10000) {
+    out += static_cast<char>(0xE0 | (cp >> 12));
+    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    out += static_cast<char>(0x80 | (cp & 0x3F));
+  } else {
+    out += static_cast<char>(0xF0 | (cp >> 18));
+    out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    out += static_cast<char>(0x80 | (cp & 0x3F));
+  }
+}
+
+} // namespace
+
+
+const char* find_string_delimiter(const char* p, const char* end)
+{
+#ifdef WJSON_SSE2
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i newline = _mm_set1_epi8('\n');
+  for (; end - p >= 16; p += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote),
+      _mm_cmpeq_epi8(v, backslash)), _mm_cmpeq_epi8(v, newline));
+    unsigned int mask = _mm_movemask_epi8(hits);
+    if (mask) return p + first_set_bit(mask);
+  }
+#endif
+  for (; p != end; ++p) {
+    if (*p == '"' || *p == '\\' || *p == '\n') return p;
+  }
+  return end;
+}
+
+
+bool is_blank(const char* p, const char* end)
+{
+  for (; p != end; ++p)
+    if (!Lexer::skipNextChar(*p)) return false;
+  return true;
+}
+
+
+const char* find_escapable(const char* p, const char* end)
+{
+#ifdef WJSON_SSE2
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i control = _mm_set1_epi8(0x1F);
+  for (; end - p >= 16; p += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    // unsigned v <= 0x1F  <=>  min(v, 0x1F) == v
+    __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote),
+      _mm_cmpeq_epi8(v, backslash)), _mm_cmpeq_epi8(_mm_min_epu8(v, control), v));
+    unsigned int mask = _mm_movemask_epi8(hits);
+    if (mask) return p + first_set_bit(mask);
+  }
+#endif
+  for (; p != end; ++p) {
+    unsigned char c = static_cast<unsigned char>(*p);
+    if (c == '"' || c == '\\' || c < 0x20) return p;
+  }
+  return end;
+}
+
+
+int escape_length(const char* p, const char* end)
+{
+  if (end - p < 2) return 0;
+  switch (p[1]) {
+    case '"': case '\\': case '/':
+    case 'b': case 'f': case 'n': case 'r': case 't':
+      return 2;
+    case 'u':
+      if (end - p < 6) return 0;
+      for (int i = 2; i < 6; ++i) {
+        if (hex_value(p[i]) < 0) return 0;
+      }
+      return 6;
+    default:
+      return 0;
+  }
+}
+
+
+void unescape_json_string(std::string_view lexeme, std::string& out)
+{
+  const char* p = lexeme.data();
+  const char* end = p + lexeme.size();
+  while (p != end) {
+    // copy everything up to the next escape in one go
+    const char* slash = static_cast<const char*>(std::memchr(p, '\\', end - p));
+    if (!slash) {
+      out.append(p, end - p);
+      return;
+    }
+    out.append(p, slash - p);
+    int len = escape_length(slash, end);
+    if (!len)
+      throw JSONException(LEXER, "Invalid escape sequence '" +
+        std::string(slash, end - slash < 6 ? end - slash : 6) + "'");
+    switch (slash[1]) {
+      case 'b': out += '\b'; break;
+      case 'f': out += '\f'; break;
+      case 'n': out += '\n'; break;
+      case 'r': out += '\r'; break;
+      case 't': out += '\t'; break;
+      case 'u':
+      {
+        unsigned int cp = read_hex4(slash + 2);
+        if (cp >= 0xD800 && cp <= 0xDBFF) {
+          // high surrogate: combine with a following low surrogate
+          const char* next = slash + 6;
+          if (end - next >= 6 && next[0] == '\\' && next[1] == 'u' && escape_length(next, end)) {
+            unsigned int low = read_hex4(next + 2);
+            if (low >= 0xDC00 && low <= 0xDFFF) {
+              append_utf8(0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00), out);
+              len += 6;
+              break;
+            }
+          }
+          cp = 0xFFFD;
+        } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+          cp = 0xFFFD;
+        }
+        append_utf8(cp, out);
+        break;
+      }
+      default: // '"', '\\', '/'
+        out += slash[1];
+        break;
+    }
+    p = slash + len;
+  }
+}
+
+
+bool json_string_equals(std::string_view lexeme, std::string_view text)
+{
+  if (!std::memchr(lexeme.data(), '\\', lexeme.size()))
+    return lexeme == text;
+  std::string decoded;
+  unescape_json_string(lexeme, decoded);
+  return decoded == text;
+}
+
+std::uint32_t hash_bytes(std::string_view bytes)
+{
+  std::uint32_t h = 2166136261u;
+  for (unsigned char c : bytes)
+    h = (h ^ c) * 16777619u;
+  return h;
+}
+
+
+void escape_json_string(std::string_view text, std::string& out)
+{
+  static const char hex[] = "0123456789abcdef";
+  const char* p = text.data();
+  const char* end = p + text.size();
+  out.reserve(out.size() + text.size());
+  while (p != end) {
+    const char* special = find_escapable(p, end);
+    out.append(p, special - p);
+    if (special == end) return;
+    switch (*special) {
+      case '"': out += "\\\""; break;
+      case '\\': out += "\\\\"; break;
+      case '\b': out += "\\b"; break;
+      case '\f': out += "\\f"; break;
+      case '\n': out += "\\n"; break;
+      case '\r': out += "\\r"; break;
+      case '\t': out += "\\t"; break;
+      default:
+        out += "\\u00";
+        out += hex[(*special >> 4) & 0xF];
+        out += hex[*special & 0xF];
+        break;
+    }
+    p = special + 1;
+  }
+}
+
+
+#endif // ifndef JSON_STRING_CPP
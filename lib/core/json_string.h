@@ -0,0 +1,48 @@
+#ifndef JSON_STRING_H
+#define JSON_STRING_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "json_exception.h"
+
+
+//----------------------------------------------------------------------
+// String scanning, escape decoding and escaping
+//----------------------------------------------------------------------
+
+// return the first '"', '\' or newline in [p, end), or end (16 bytes per
+// step on x86-64)
+const char* find_string_delimiter(const char* p, const char* end);
+
+// whether [p, end) holds only whitespace (the characters the lexer skips)
+bool is_blank(const char* p, const char* end);
+
+// return the first character in [p, end) that JSON requires to be
+// escaped ('"', '\' or a control character), or end
+const char* find_escapable(const char* p, const char* end);
+
+// length of the escape sequence starting at the backslash p (2, or 6 for
+// \uXXXX), or 0 if it is not a valid JSON escape
+int escape_length(const char* p, const char* end);
+
+// decode a string lexeme (the text between the quotes) to UTF-8 and
+// append it to out. Unescaped runs are copied in bulk; a lone UTF-16
+// surrogate decodes to U+FFFD. Throws a LEXER JSONException on an invalid
+// escape sequence
+void unescape_json_string(std::string_view lexeme, std::string& out);
+
+// whether the string lexeme decodes to text (decodes only if the lexeme
+// has an escape sequence)
+bool json_string_equals(std::string_view lexeme, std::string_view text);
+
+// FNV-1a hash of bytes (object keys in the lookup index and the symbol
+// table)
+std::uint32_t hash_bytes(std::string_view bytes);
+
+// escape UTF-8 text for use between quotes in JSON output and append it
+// to out
+void escape_json_string(std::string_view text, std::string& out);
+
+
+#endif // ifndef JSON_STRING_H
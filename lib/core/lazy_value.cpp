@@ -0,0 +1,331 @@
+#ifndef LAZY_VALUE_CPP
+#define LAZY_VALUE_CPP
+
+#include "lazy_value.h"
+#include "json_string.h"
+#include "parser.h"
+
+
+namespace {
+
+void syntax_error(const std::string& msg, const Token& t)
+{
+  throw JSONException(SYNTAX, msg + "found '" + std::string(t.lexeme()) + "'", t.line(), t.column());
+}
+
+void semantic_error(const std::string& msg, const Token& t)
+{
+  throw JSONException(SEMANTIC, msg, t.line(), t.column());
+}
+
+// where the text of t starts and ends (strings include their quotes)
+const char* token_start(const Token& t)
+{
+  return t.type() == STRING_VAL ? t.lexeme().data() - 1 : t.lexeme().data();
+}
+
+const char* token_end(const Token& t, int& line, int& column)
+{
+  std::size_t quotes = t.type() == STRING_VAL ? 2 : 0;
+  line = t.line();
+  column = t.column() + static_cast<int>(t.lexeme().size() + quotes);
+  return token_start(t) + t.lexeme().size() + quotes;
+}
+
+// the end of the container opened by open, scanning from p (just past
+// it, at line and column) for the matching bracket; only brackets and
+// string boundaries are looked at
+const char* skip_container(const Token& open, const char* p, const char* end, int& line, int& column)
+{
+  const char* line_start = p - (column - 1);
+  std::size_t depth = 1;
+  while (p != end) {
+    switch (*p++) {
+      case '"': {
+        const char* quote = p - 1;
+        while (1) {
+          p = find_string_delimiter(p, end);
+          if (p == end || *p == '\n')
+            throw JSONException(LEXER, "string values require an opening and closing quotation mark",
+                                line, static_cast<int>(quote - line_start) + 1);
+          if (*p == '"') break;
+          // the character after a backslash (never a newline)
+          if (++p != end && *p != '\n') ++p;
+        }
+        ++p;
+        break;
+      }
+      case '\n':
+        ++line;
+        line_start = p;
+        break;
+      case '[':
+      case '{':
+        ++depth;
+        break;
+      case ']':
+      case '}':
+        if (!--depth) {
+          column = static_cast<int>(p - line_start) + 1;
+          return p;
+        }
+        break;
+      default:
+        break;
+    }
+  }
+  throw JSONException(SYNTAX, "Unexpected end-of-file: '" + std::string(open.lexeme()) + "' is not closed",
+                      open.line(), open.column());
+}
+
+} // namespace
+
+
+LazyValue LazyValue::root(std::string_view input)
+{
+  Lexer lexer(input);
+  return value_at(lexer.next_token(), input.data() + input.size(), Token());
+}
+
+
+LazyValue LazyValue::value_at(const Token& first, const char* input_end, const Token& key)
+{
+  switch (first.type()) {
+    case LBRACE:
+    case LBRACKET:
+    case STRING_VAL:
+    case NUMBER_VAL:
+    case LITERAL_VAL:
+      break;
+    default:
+      syntax_error("Unexpected token: expected value, ", first);
+  }
+  LazyValue value;
+  value.input_end = input_end;
+  value.token = first;
+  value.member_key = key;
+  return value;
+}
+
+
+ValueType LazyValue::type() const
+{
+  switch (token.type()) {
+    case LBRACE: return JSON_TYPE;
+    case LBRACKET: return ARRAY_TYPE;
+    case STRING_VAL: return STRING_TYPE;
+    case NUMBER_VAL: return NUMBER_TYPE;
+    default: return LITERAL_TYPE;
+  }
+}
+
+
+Token LazyValue::first_token() const
+{
+  return token;
+}
+
+
+Token LazyValue::key() const
+{
+  return member_key;
+}
+
+
+std::string LazyValue::key_string() const
+{
+  std::string s;
+  unescape_json_string(member_key.lexeme(), s);
+  return s;
+}
+
+
+Lexer LazyValue::after() const
+{
+  int line, column;
+  const char* p = token_end(token, line, column);
+  return Lexer(p, input_end - p, line, column);
+}
+
+
+const char* LazyValue::value_end(int& line, int& column) const
+{
+  const char* p = token_end(token, line, column);
+  if (token.type() == LBRACE || token.type() == LBRACKET)
+    p = skip_container(token, p, input_end, line, column);
+  return p;
+}
+
+
+std::string_view LazyValue::text() const
+{
+  int line, column;
+  const char* start = token_start(token);
+  return std::string_view(start, value_end(line, column) - start);
+}
+
+
+bool LazyValue::find(std::string_view name, LazyValue& value) const
+{
+  if (token.type() != LBRACE)
+    semantic_error("value is not an object", token);
+  for (Iterator i = begin(); i != end(); ++i) {
+    if (json_string_equals(i->member_key.lexeme(), name)) {
+      value = *i;
+      return true;
+    }
+  }
+  return false;
+}
+
+
+LazyValue LazyValue::operator[](std::string_view name) const
+{
+  LazyValue value;
+  if (!find(name, value))
+    semantic_error("no member '" + std::string(name) + "'", token);
+  return value;
+}
+
+
+LazyValue LazyValue::at(std::size_t index) const
+{
+  if (token.type() != LBRACKET)
+    semantic_error("value is not an array", token);
+  std::size_t n = 0;
+  for (Iterator i = begin(); i != end(); ++i, ++n)
+    if (n == index)
+      return *i;
+  semantic_error("index " + std::to_string(index) + " is out of range", token);
+  return LazyValue(); // unreachable
+}
+
+
+LazyValue::Iterator LazyValue::begin() const
+{
+  Iterator i;
+  i.start(*this);
+  return i;
+}
+
+
+LazyValue::Iterator LazyValue::end() const
+{
+  return Iterator();
+}
+
+
+SimpleRValue LazyValue::scalar() const
+{
+  if (token.type() == LBRACE || token.type() == LBRACKET)
+    semantic_error("value is not a scalar", token);
+  SimpleRValue node;
+  node.value = token;
+  node.type = type();
+  return node;
+}
+
+
+std::string LazyValue::as_string() const
+{
+  if (token.type() != STRING_VAL)
+    semantic_error("value is not a string", token);
+  return scalar().as_string();
+}
+
+
+std::int64_t LazyValue::as_int64() const
+{
+  if (token.type() != NUMBER_VAL)
+    semantic_error("value is not a number", token);
+  return scalar().as_int64();
+}
+
+
+std::uint64_t LazyValue::as_uint64() const
+{
+  if (token.type() != NUMBER_VAL)
+    semantic_error("value is not a number", token);
+  return scalar().as_uint64();
+}
+
+
+double LazyValue::as_double() const
+{
+  if (token.type() != NUMBER_VAL)
+    semantic_error("value is not a number", token);
+  return scalar().as_double();
+}
+
+
+void LazyValue::parse(JSONDocument& doc) const
+{
+  int line, column;
+  const char* start = token_start(token);
+  const char* end = value_end(line, column);
+  Lexer lexer(start, end - start, token.line(), token.column());
+  Parser parser(lexer);
+  parser.parse(doc);
+}
+
+
+//----------------------------------------------------------------------
+// Iterator
+//----------------------------------------------------------------------
+
+void LazyValue::Iterator::start(const LazyValue& container)
+{
+  if (container.token.type() != LBRACE && container.token.type() != LBRACKET)
+    semantic_error("value is not an object or array", container.token);
+  in_object = container.token.type() == LBRACE;
+  current.input_end = container.input_end;
+  Lexer lexer = container.after();
+  Token t = lexer.next_token();
+  if (t.type() == (in_object ? RBRACE : RBRACKET))
+    return;
+  element(lexer, t);
+}
+
+
+void LazyValue::Iterator::element(Lexer& lexer, Token t)
+{
+  Token key;
+  if (in_object) {
+    if (t.type() != STRING_VAL)
+      syntax_error("Unexpected token: expected string, ", t);
+    key = t;
+    t = lexer.next_token();
+    if (t.type() != COLON)
+      syntax_error("Unexpected token: expected ':', ", t);
+    t = lexer.next_token();
+  }
+  current = value_at(t, current.input_end, key);
+  at_end = false;
+}
+
+
+LazyValue::Iterator& LazyValue::Iterator::operator++()
+{
+  int line, column;
+  const char* p = current.value_end(line, column);
+  Lexer lexer(p, current.input_end - p, line, column);
+  Token t = lexer.next_token();
+  if (t.type() == COMMA)
+    element(lexer, lexer.next_token());
+  else if (t.type() == (in_object ? RBRACE : RBRACKET))
+    at_end = true;
+  else
+    syntax_error(in_object ? "Unexpected token: expected ',', " : "Unexpected token: expected ']', ", t);
+  return *this;
+}
+
+
+bool LazyValue::Iterator::operator==(const Iterator& other) const
+{
+  if (at_end || other.at_end)
+    return at_end == other.at_end;
+  return current.token.lexeme().data() == other.current.token.lexeme().data();
+}
+
+
+#endif // ifndef LAZY_VALUE_CPP
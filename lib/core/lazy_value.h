@@ -0,0 +1,128 @@
+#ifndef LAZY_VALUE_H
+#define LAZY_VALUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include "token.h"
+#include "lexer.h"
+#include "ast.h"
+
+
+//----------------------------------------------------------------------
+// On-demand navigation without building a tree
+//----------------------------------------------------------------------
+
+// A cursor on one value of an input buffer. Only the tokens a caller
+// reads are lexed: looking up a member or stepping to the next element
+// passes over the values in between by matching brackets, without
+// lexing them or building nodes. Values are therefore validated only as
+// far as they are read; a skipped value is only checked for balanced
+// brackets and closed strings, and nothing after the root is read.
+// Errors are JSONExceptions with positions in the whole input. Cursors
+// are small, independent copies; the input must outlive them.
+class LazyValue
+{
+  public:
+    class Iterator;
+
+    // the root value of input
+    static LazyValue root(std::string_view input);
+
+    ValueType type() const;
+
+    // the value's first token (the whole value for scalars)
+    Token first_token() const;
+
+    // the key this value was reached under, or an EOS token if it is not
+    // an object member
+    Token key() const;
+    // the key with escape sequences decoded (UTF-8)
+    std::string key_string() const;
+
+    // the text of the value in the input (skips a container to find it)
+    std::string_view text() const;
+
+    // the value of the first member named key (compared with escape
+    // sequences decoded), scanning the object from its start; false if
+    // there is none. Throws a SEMANTIC JSONException if this is not an
+    // object
+    bool find(std::string_view key, LazyValue& value) const;
+
+    // the same, chainable (doc["a"]["b"]), throwing a SEMANTIC
+    // JSONException if there is no such member
+    LazyValue operator[](std::string_view key) const;
+
+    // the element at index of an array (a SEMANTIC JSONException if this
+    // is not an array or is too short)
+    LazyValue at(std::size_t index) const;
+
+    // the elements of an array or the members of an object in order
+    // (members carry their key()); a SEMANTIC JSONException for scalars
+    Iterator begin() const;
+    Iterator end() const;
+
+    // the value as a detached node, for the conversions of SimpleRValue
+    // (a SEMANTIC JSONException for containers)
+    SimpleRValue scalar() const;
+    std::string as_string() const;
+    std::int64_t as_int64() const;
+    std::uint64_t as_uint64() const;
+    double as_double() const;
+
+    // build this value and everything in it as a tree, validating it
+    // fully (the tree's tokens point into the input)
+    void parse(JSONDocument&) const;
+
+  private:
+    const char* input_end = nullptr;
+    Token token;
+    Token member_key;
+
+    // a lexer over the input just past token
+    Lexer after() const;
+    // the end of the value, with its line and column
+    const char* value_end(int& line, int& column) const;
+    // the value starting with first (a SYNTAX JSONException if no value
+    // starts there)
+    static LazyValue value_at(const Token& first, const char* input_end, const Token& key);
+
+    friend class Iterator;
+    friend class PathQuery;
+};
+
+
+// Forward iteration over the children of a container. Stepping past a
+// child skips it again from its start, whether or not it was entered.
+class LazyValue::Iterator
+{
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = LazyValue;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const LazyValue*;
+    using reference = const LazyValue&;
+
+    const LazyValue& operator*() const { return current; }
+    const LazyValue* operator->() const { return &current; }
+    Iterator& operator++();
+    bool operator==(const Iterator& other) const;
+    bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+  private:
+    LazyValue current;
+    bool in_object = false;
+    bool at_end = true;
+
+    // the first child of container (or the end if it is empty)
+    void start(const LazyValue& container);
+    // read the child that starts with first, the rest following in lexer
+    void element(Lexer& lexer, Token first);
+
+    friend class LazyValue;
+};
+
+
+#endif // ifndef LAZY_VALUE_H
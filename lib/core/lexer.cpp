@@ -2,9 +2,43 @@
 #define LEXER_CPP
 
 
+#include <cstring>
 #include <istream>
 #include <string>
 #include "lexer.h"
+#include "json_string.h"
+
+// isdigit() without the locale lookup (and safe for negative chars)
+static inline bool isDigit(const char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+// return the first backslash in [p, end) that does not start a valid escape
+// sequence, or nullptr
+static const char* findInvalidEscape(const char* p, const char* end)
+{
+	while((p = static_cast<const char*>(std::memchr(p, '\\', end - p))))
+	{
+		int len = escape_length(p, end);
+		if(!len)
+			return p;
+		p += len;
+	}
+	return nullptr;
+}
+
+// read the remainder of the stream into a new buffer
+static std::shared_ptr<const std::string> readStream(std::istream& input_stream)
+{
+	std::shared_ptr<std::string> buf = std::make_shared<std::string>();
+	char chunk[1 << 16];
+	while(input_stream.read(chunk, sizeof(chunk)) || input_stream.gcount())
+	{
+		buf->append(chunk, input_stream.gcount());
+	}
+	return buf;
+}
 
 bool Lexer::isValidIdentifier(int c)
 {
@@ -13,47 +47,142 @@ bool Lexer::isValidIdentifier(int c)
 
 bool Lexer::skipNextChar(const char& c)
 {
-	return isspace(c);
+	// same set as isspace() in the "C" locale
+	return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+Lexer::Lexer(const char* input, std::size_t length)
+	: input_begin(input), input_end(input + length), curr(input), line(1), column(1),
+	  index_next(nullptr), index_end(nullptr), stream(nullptr), chunk_size(0), reached_end(false)
+{
+}
+
+Lexer::Lexer(std::string_view input)
+	: Lexer(input.data(), input.size())
+{
+}
+
+Lexer::Lexer(const char* input, std::size_t length, int start_line, int start_column)
+	: Lexer(input, length)
+{
+	line = start_line;
+	column = start_column;
 }
 
 Lexer::Lexer(std::istream& input_stream)
-	: input_stream(input_stream), line(1), column(1)
+	: Lexer(readStream(input_stream))
 {
 }
 
+Lexer::Lexer(std::shared_ptr<const std::string> input)
+	: owned_input(input), input_begin(input->data()),
+	  input_end(input->data() + input->size()), curr(input->data()), line(1), column(1),
+	  index_next(nullptr), index_end(nullptr), stream(nullptr), chunk_size(0), reached_end(false)
+{
+}
 
-char Lexer::read()
+Lexer::Lexer(std::istream& input_stream, std::size_t chunk)
+	: input_begin(nullptr), input_end(nullptr), curr(nullptr), line(1), column(1),
+	  index_next(nullptr), index_end(nullptr), stream(&input_stream),
+	  window(std::make_shared<std::string>()), chunk_size(chunk ? chunk : 1), reached_end(false)
+{
+	input_begin = input_end = curr = window->data();
+}
+
+
+void Lexer::refill(const char* keep)
+{
+	std::string& buf = *window;
+	std::size_t kept = input_end - keep;
+	buf.erase(0, keep - buf.data());
+	// read at least as much as is kept, so a token spanning many chunks
+	// is rescanned a logarithmic number of times
+	std::size_t wanted = kept > chunk_size ? kept : chunk_size;
+	buf.resize(kept + wanted);
+	stream->read(&buf[kept], wanted);
+	std::size_t got = stream->gcount();
+	buf.resize(kept + got);
+	if(got < wanted)
+	{
+		stream = nullptr;
+	}
+	input_begin = curr = buf.data();
+	input_end = input_begin + buf.size();
+}
+
+
+void Lexer::use_structural_index(StructuralIndex::Implementation impl)
+{
+	if(window)
+	{
+		return;
+	}
+	std::shared_ptr<StructuralIndex> index = std::make_shared<StructuralIndex>();
+	index->build(input(), impl);
+	structural_index = index;
+	index_next = index->positions.data();
+	index_end = index_next + index->positions.size();
+}
+
+const char* Lexer::indexed_string_end()
 {
-	return input_stream.get();
+	// skip entries for tokens the lexer has already consumed
+	while(index_next != index_end && input_begin + *index_next < curr)
+	{
+		++index_next;
+	}
+	if(index_next == index_end || input_begin[*index_next] != '"')
+	{
+		return nullptr;
+	}
+	return input_begin + *index_next++;
 }
 
-int Lexer::read(char* buf, const int& n)
+
+std::string_view Lexer::input() const
 {
-	input_stream.read(buf, n);
-	return input_stream.gcount();
+	return std::string_view(input_begin, input_end - input_begin);
 }
 
-unsigned int Lexer::read_u32(const int& n)
+std::shared_ptr<const void> Lexer::input_owner() const
 {
-	unsigned int val = 0;
-	int len = n > 4 ? 4 : n;
-	switch(len) {
-		case 4:
-			val |= read() << 24;
-		case 3:
-			val |= read() << 16;
-		case 2:
-			val |= read() << 8;
-		case 1:
-			val |= read();
+	return owned_input;
+}
+
+bool Lexer::stable_tokens() const
+{
+	return !window;
+}
+
+
+char Lexer::read()
+{
+	if(curr != input_end)
+		return *curr++;
+	reached_end = true;
+	return EOF;
+}
+
+bool Lexer::match(const char* str, const int& n)
+{
+	if(input_end - curr < n)
+	{
+		reached_end = true;
+		return false;
 	}
+	if(std::memcmp(curr, str, n) != 0)
+		return false;
+	curr += n;
 	column += n;
-	return val;
+	return true;
 }
 
 char Lexer::peek()
 {
-	return input_stream.peek();
+	if(curr != input_end)
+		return *curr;
+	reached_end = true;
+	return EOF;
 }
 
 
@@ -70,151 +199,189 @@ char Lexer::readNextChar()
 
 Token Lexer::next_token()
 {
-	Token token;
-	char nextChar;
-	std::string lexeme = "";
-	while(skipNextChar(peek()))
+	return stream ? next_streamed_token() : scan_token();
+}
+
+// a token that runs into the end of the window may be cut short, so read
+// more and scan it again
+Token Lexer::next_streamed_token()
+{
+	while(1)
+	{
+		const char* start = curr;
+		int startLine = line;
+		int startColumn = column;
+		reached_end = false;
+		try
+		{
+			Token token = scan_token();
+			if(!reached_end || !stream)
+			{
+				return token;
+			}
+		} catch(JSONException&) {
+			if(!reached_end || !stream)
+			{
+				throw;
+			}
+		}
+		curr = start;
+		line = startLine;
+		column = startColumn;
+		refill(start);
+	}
+}
+
+Token Lexer::scan_token()
+{
+	while(curr != input_end && skipNextChar(*curr))
 	{
-		nextChar = read();
-		if(nextChar == '\n')
+		if(*curr == '\n')
 		{
 			line += 1;
 			column = 1;
 		} else {
 			column += 1;
 		}
+		++curr;
 	}
 	int startColumn = column;
 	int startLine = line;
-	nextChar = readNextChar();
-	lexeme += nextChar;
+	if(curr == input_end)
+	{
+		reached_end = true;
+		return Token(EOS, std::string_view(curr, 0), startLine, startColumn);
+	}
+	const char* start = curr;
+	char nextChar = readNextChar();
 	switch(nextChar) {
-		case EOF:
-			token = Token(EOS, "", startLine, startColumn);
-			break;
 		case '{':
-			token = Token(LBRACE, "{", startLine, startColumn);
-			break;
+			return Token(LBRACE, std::string_view(start, 1), startLine, startColumn);
 		case '}':
-			token = Token(RBRACE, "}", startLine, startColumn);
-			break;
+			return Token(RBRACE, std::string_view(start, 1), startLine, startColumn);
 		case '[':
-			token = Token(LBRACKET, "[", startLine, startColumn);
-			break;
+			return Token(LBRACKET, std::string_view(start, 1), startLine, startColumn);
 		case ']':
-			token = Token(RBRACKET, "]", startLine, startColumn);
-			break;
+			return Token(RBRACKET, std::string_view(start, 1), startLine, startColumn);
 		case ':':
-			token = Token(COLON, ":", startLine, startColumn);
-			break;
+			return Token(COLON, std::string_view(start, 1), startLine, startColumn);
 		case ',':
-			token = Token(COMMA, ",", startLine, startColumn);
-			break;
+			return Token(COMMA, std::string_view(start, 1), startLine, startColumn);
 		case '"':
-			// string
-			lexeme = "";
-			while(peek() != '"')
+		{
+			// string (the index already checked for a closing quote on this line)
+			const char* end = indexed_string_end();
+			if(end)
 			{
-				nextChar = readNextChar();
-				if(nextChar == '\\') //handle escapes (primarily for quote escape)
+				const char* bad = findInvalidEscape(curr, end);
+				if(bad)
 				{
-					lexeme += nextChar;
-					nextChar = readNextChar();
+					error("Invalid token '\"" + std::string(curr, bad + 2) + "': invalid escape sequence,", startLine, startColumn);
 				}
-				if(nextChar == EOF || nextChar == '\n')
-				{
-					error("Invalid token '\"" + lexeme + "': string values require an opening and closing quotation mark,", startLine, startColumn);
-				}
-				lexeme += nextChar;
+				Token token(STRING_VAL, std::string_view(curr, end - curr), startLine, startColumn);
+				column += (end - curr) + 1;
+				curr = end + 1;
+				return token;
 			}
-			nextChar = readNextChar();
-			token = Token(STRING_VAL, lexeme, startLine, startColumn);
-			break;
-		default:
-			if(isdigit(nextChar) || nextChar == '-')
+			// find the closing quote 16 bytes at a time, stopping only to
+			// check escapes (primarily for quote escape)
+			end = curr;
+			while(1)
 			{
-				if(nextChar == '-')
-				{
-					nextChar = readNextChar();
-					lexeme += nextChar;
-					if(!isdigit(nextChar)) {
-						error("Invalid token,", startLine, startColumn);
-					}
-				}
-				bool leadingZero = nextChar == '0';
-				if(leadingZero && peek() == '0') {
-					error("Invalid token: leading 0's are not allowed,", startLine, startColumn);
-				}
-				while(isdigit(peek()))
+				end = find_string_delimiter(end, input_end);
+				if(end == input_end || *end == '\n')
 				{
-					nextChar = readNextChar();
-					lexeme += nextChar;
+					reached_end = end == input_end;
+					error("Invalid token '\"" + std::string(curr, end) + "': string values require an opening and closing quotation mark,", startLine, startColumn);
 				}
-				if(peek() == '.')
+				if(*end == '"')
 				{
-					// double literal
-					nextChar = readNextChar();
-					lexeme += nextChar;
-					// need to finish reading numbers in
-					if(!isdigit(peek()))
-					{
-						// no numbers after dot error
-						error("Invalid token: '" + lexeme + "': double values must have at least one trailing digit,", startLine, startColumn);
-					}
-					while(isdigit(peek()))
-					{
-						nextChar = readNextChar();
-						lexeme += nextChar;
-					}
+					break;
 				}
-				if(peek() == 'e' || peek() == 'E')
+				int len = escape_length(end, input_end);
+				if(!len)
 				{
-					nextChar = readNextChar();
-					lexeme += nextChar;
-					nextChar = readNextChar();
-					if(nextChar == '-' || nextChar == '+')
-					{
-						lexeme += nextChar;
-						nextChar = readNextChar();
-					}
-					if(!isdigit(nextChar))
-					{
-						error("Invalid token: '" + lexeme + "':", startLine, startColumn);
-					}
-					lexeme += nextChar;
-					while(isdigit(peek()))
-					{
-						nextChar = readNextChar();
-						lexeme += nextChar;
-					}
-				}
-				token = Token(NUMBER_VAL, lexeme, startLine, startColumn);
-			} else if(nextChar == 't') {
-				const unsigned int MAGIC_NUMBER = 0x727565;
-				unsigned int buf = read_u32(3);
-				if(~(buf ^~ MAGIC_NUMBER)) {
-					error("Invalid token '\"" + lexeme + "'", startLine, startColumn);
-				}
-				token = Token(LITERAL_VAL, "true", startLine, startColumn);
-			} else if(nextChar == 'f') {
-				const unsigned int MAGIC_NUMBER = 0x616c7365;
-				unsigned int buf = read_u32(4);
-				if(~(buf ^~ MAGIC_NUMBER)) {
-					error("Invalid token '\"" + lexeme + "'", startLine, startColumn);
-				}
-				token = Token(LITERAL_VAL, "false", startLine, startColumn);
-			} else if(nextChar == 'n') {
-				const unsigned int MAGIC_NUMBER = 0x756c6c;
-				unsigned int buf = read_u32(3);
-				if(~(buf ^~ MAGIC_NUMBER)) {
-					error("Invalid token '\"" + lexeme + "'", startLine, startColumn);
+					reached_end = input_end - end < 6;
+					error("Invalid token '\"" + std::string(curr, end + (end + 1 != input_end ? 2 : 1)) + "': invalid escape sequence,", startLine, startColumn);
 				}
-				token = Token(LITERAL_VAL, "null", startLine, startColumn);
-			} else {
-				error("Invalid token '\"" + lexeme + "'", startLine, startColumn);
+				end += len;
 			}
+			Token token(STRING_VAL, std::string_view(curr, end - curr), startLine, startColumn);
+			column += (end - curr) + 1;
+			curr = end + 1;
+			return token;
+		}
+		default:
+			break;
+	}
+	if(isDigit(nextChar) || nextChar == '-')
+	{
+		if(nextChar == '-')
+		{
+			nextChar = readNextChar();
+			if(!isDigit(nextChar)) {
+				error("Invalid token,", startLine, startColumn);
+			}
+		}
+		bool leadingZero = nextChar == '0';
+		if(leadingZero && peek() == '0') {
+			error("Invalid token: leading 0's are not allowed,", startLine, startColumn);
+		}
+		while(isDigit(peek()))
+		{
+			readNextChar();
+		}
+		if(peek() == '.')
+		{
+			// double literal
+			readNextChar();
+			// need to finish reading numbers in
+			if(!isDigit(peek()))
+			{
+				// no numbers after dot error
+				error("Invalid token: '" + std::string(start, curr) + "': double values must have at least one trailing digit,", startLine, startColumn);
+			}
+			while(isDigit(peek()))
+			{
+				readNextChar();
+			}
+		}
+		if(peek() == 'e' || peek() == 'E')
+		{
+			readNextChar();
+			nextChar = readNextChar();
+			if(nextChar == '-' || nextChar == '+')
+			{
+				nextChar = readNextChar();
+			}
+			if(!isDigit(nextChar))
+			{
+				error("Invalid token: '" + std::string(start, curr) + "':", startLine, startColumn);
+			}
+			while(isDigit(peek()))
+			{
+				readNextChar();
+			}
+		}
+		return Token(NUMBER_VAL, std::string_view(start, curr - start), startLine, startColumn);
+	} else if(nextChar == 't') {
+		if(!match("rue", 3)) {
+			error("Invalid token '\"" + std::string(start, curr) + "'", startLine, startColumn);
+		}
+		return Token(LITERAL_VAL, std::string_view(start, curr - start), startLine, startColumn);
+	} else if(nextChar == 'f') {
+		if(!match("alse", 4)) {
+			error("Invalid token '\"" + std::string(start, curr) + "'", startLine, startColumn);
+		}
+		return Token(LITERAL_VAL, std::string_view(start, curr - start), startLine, startColumn);
+	} else if(nextChar == 'n') {
+		if(!match("ull", 3)) {
+			error("Invalid token '\"" + std::string(start, curr) + "'", startLine, startColumn);
+		}
+		return Token(LITERAL_VAL, std::string_view(start, curr - start), startLine, startColumn);
 	}
-	return token;
+	error("Invalid token '\"" + std::string(start, curr) + "'", startLine, startColumn);
+	return Token(); // unreachable
 }
 
 #endif // ifndef LEXER_CPP
@@ -2,10 +2,14 @@
 #define LEXER_H
 
 
+#include <cstddef>
 #include <istream>
+#include <memory>
 #include <string>
+#include <string_view>
 #include "token.h"
 #include "json_exception.h"
+#include "structural_index.h"
 
 class Lexer
 {
@@ -14,33 +18,103 @@ class Lexer
 
 		static bool skipNextChar(const char&);
 
-		// construct a new lexer from the input stream
+		// construct a new lexer over a contiguous input buffer. The buffer is
+		// not copied and must outlive the lexer
+		Lexer(const char* input, std::size_t length);
+		Lexer(std::string_view input);
+
+		// construct a lexer over part of a larger buffer that starts at the
+		// given line and column of it, so tokens and errors carry positions
+		// in the whole buffer
+		Lexer(const char* input, std::size_t length, int line, int column);
+
+		// construct a new lexer from the input stream (the stream is read to
+		// the end into a buffer owned by the lexer)
 		Lexer(std::istream&);
 
+		// construct a streaming lexer that reads the stream chunk_size bytes
+		// at a time, so memory stays bounded by the largest token. Tokens are
+		// only valid until the next call to next_token(), and copies of the
+		// lexer share one window over the stream (use only one of them)
+		Lexer(std::istream&, std::size_t chunk_size);
+
 		// return the next available token in the input stream (including
 		// EOS if at the end of the stream)
 		Token next_token();
 
+		// build a stage-one structural index over the whole input and use it
+		// to find the end of strings instead of scanning them byte by byte
+		// (string errors are then reported before any other error). Does
+		// nothing for a streaming lexer, which never has the whole input
+		void use_structural_index(StructuralIndex::Implementation = StructuralIndex::AUTO);
+
+		// return the input buffer being scanned
+		std::string_view input() const;
+
+		// return the owner of the input buffer if the lexer allocated it
+		// (tokens point into the buffer, so holders of tokens keep this alive)
+		std::shared_ptr<const void> input_owner() const;
+
+		// true if tokens stay valid for as long as the input buffer does
+		// (false for a streaming lexer, whose window is reused)
+		bool stable_tokens() const;
+
 	private:
 
-		// input stream, current line, and current column
-		std::istream& input_stream;
+		// keeps the buffer alive when the lexer was constructed from a stream
+		// (shared so that copies of the lexer stay valid)
+		std::shared_ptr<const void> owned_input;
+
+		// input buffer bounds, current position, current line, and current column
+		const char* input_begin;
+		const char* input_end;
+		const char* curr;
 		int line;
 		int column;
 
-		// return a single character from the input stream and advance
-		char read();
+		// structural index (if enabled) and the next unconsumed entry
+		std::shared_ptr<const StructuralIndex> structural_index;
+		const std::size_t* index_next;
+		const std::size_t* index_end;
 
-		// read the next n characters from the input stream and store them in buf.
-		// returns actual number of characters read
-		int read(char* buf, const int& n);
+		// streaming mode: the stream (until it is exhausted), the window the
+		// input bounds point into, and the read size
+		std::istream* stream;
+		std::shared_ptr<std::string> window;
+		std::size_t chunk_size;
 
-		// read up to the next 4 characters as bytes and return as a 32-bit unsigned integer
-		unsigned int read_u32(const int&);
+		// set when scanning looked at the end of the input, in which case a
+		// streaming lexer rescans the token after reading more
+		bool reached_end;
 
-		// return a single character from the input stream without advancing
+		// construct a lexer that owns its input buffer
+		Lexer(std::shared_ptr<const std::string>);
+
+		// scan the next token from the buffer
+		Token scan_token();
+
+		// next_token() for a streaming lexer
+		Token next_streamed_token();
+
+		// move the bytes from keep onwards to the front of the window and
+		// append the next chunk of the stream
+		void refill(const char* keep);
+
+		// return a single character from the input buffer and advance
+		// (EOF at the end of the buffer)
+		char read();
+
+		// if the next n characters match str, consume them and return true
+		bool match(const char* str, const int& n);
+
+		// return a single character from the input buffer without advancing
+		// (EOF at the end of the buffer)
 		char peek();
 
+		// return the closing quote of the string starting at curr from the
+		// structural index, or nullptr if there is no index
+		const char* indexed_string_end();
+
 		// create and throw a mypl_exception (exits the lexer)
 		void error(const std::string&, int, int) const;
 
@@ -0,0 +1,93 @@
+#ifndef MAPPED_FILE_CPP
+#define MAPPED_FILE_CPP
+
+#include <cerrno>
+#include <system_error>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "mapped_file.h"
+
+
+namespace {
+
+[[noreturn]] void fail(const std::string& what, const std::string& name)
+{
+  throw std::system_error(errno, std::generic_category(), what + " " + name);
+}
+
+} // namespace
+
+
+MappedFile::MappedFile(const std::string& path)
+  : begin(nullptr), length(0), mapping(nullptr), mapping_length(0)
+{
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) fail("cannot open", path);
+  try {
+    load(fd, path);
+  } catch (...) {
+    ::close(fd);
+    throw;
+  }
+  ::close(fd);
+}
+
+
+MappedFile::MappedFile(int fd)
+  : begin(nullptr), length(0), mapping(nullptr), mapping_length(0)
+{
+  load(fd, "file descriptor " + std::to_string(fd));
+}
+
+
+MappedFile::~MappedFile()
+{
+  if (mapping) ::munmap(mapping, mapping_length);
+}
+
+
+void MappedFile::load(int fd, const std::string& name)
+{
+  struct stat info;
+  if (::fstat(fd, &info) < 0) fail("cannot stat", name);
+
+  // mmap() of an empty file fails, and there is nothing to map anyway
+  if (S_ISREG(info.st_mode) && info.st_size > 0) {
+    // map from the current offset (standard input may have been read from)
+    off_t offset = ::lseek(fd, 0, SEEK_CUR);
+    if (offset < 0) offset = 0;
+    std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    off_t aligned = offset - offset % static_cast<off_t>(page);
+    std::size_t size = static_cast<std::size_t>(info.st_size - aligned);
+    void* p = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, aligned);
+    if (p != MAP_FAILED) {
+      // read ahead aggressively and drop pages behind the scan
+      ::madvise(p, size, MADV_SEQUENTIAL);
+      mapping = p;
+      mapping_length = size;
+      // only the bytes from the offset on are data
+      begin = static_cast<const char*>(p) + (offset - aligned);
+      length = size - (offset - aligned);
+      return;
+    }
+    // fall back to reading (e.g. a file system without mmap support)
+  }
+
+  char chunk[1 << 16];
+  while (true) {
+    ssize_t got = ::read(fd, chunk, sizeof(chunk));
+    if (got < 0) {
+      if (errno == EINTR) continue;
+      fail("cannot read", name);
+    }
+    if (got == 0) break;
+    copy.append(chunk, got);
+  }
+  begin = copy.data();
+  length = copy.size();
+}
+
+
+#endif // ifndef MAPPED_FILE_CPP
@@ -0,0 +1,65 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+
+//----------------------------------------------------------------------
+// Memory-mapped input
+//----------------------------------------------------------------------
+
+// The whole contents of a file as one read-only buffer, for the
+// Lexer(const char*, size_t) constructor: a regular file is mapped (with a
+// sequential-access hint), so parsing it needs no read() copies and tokens
+// point straight into the page cache. Anything that cannot be mapped
+// (pipes, terminals, sockets) is read into memory instead. Throws
+// std::system_error if the file cannot be opened or read. Tokens point
+// into the buffer, so a JSONDocument built from it must not outlive it
+// (hold it in a shared_ptr and store that in JSONDocument::source).
+class MappedFile
+{
+  public:
+    // map or read the file at path
+    explicit MappedFile(const std::string& path);
+
+    // map or read an open file descriptor (e.g. 0 for standard input,
+    // which is mapped when redirected from a file); fd is not closed
+    explicit MappedFile(int fd);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::string_view data() const;
+
+    // true if the contents are mapped rather than copied
+    bool mapped() const;
+
+  private:
+    const char* begin;
+    std::size_t length;
+    // the whole mapping (from a page boundary), non-null when mapped
+    void* mapping;
+    std::size_t mapping_length;
+    // the contents when they could not be mapped
+    std::string copy;
+
+    void load(int fd, const std::string& name);
+};
+
+
+inline std::string_view MappedFile::data() const
+{
+  return std::string_view(begin, length);
+}
+
+inline bool MappedFile::mapped() const
+{
+  return mapping != nullptr;
+}
+
+
+#endif // ifndef MAPPED_FILE_H
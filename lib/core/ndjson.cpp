@@ -0,0 +1,246 @@
+#ifndef NDJSON_CPP
+#define NDJSON_CPP
+
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "ndjson.h"
+#include "json_string.h"
+#include "lexer.h"
+#include "parser.h"
+
+
+// a run of whole lines and, once parsed, its records
+struct NDJSONReader::Batch
+{
+  std::string_view text;
+  // offset of text in the input
+  std::size_t offset = 0;
+  // owns text for stream input (and is kept alive by the documents)
+  std::shared_ptr<const std::string> owner;
+
+  // parsed records with their offsets (ORDERED only)
+  std::vector<std::pair<std::unique_ptr<JSONDocument>, std::size_t>> records;
+  // newlines in text, counted as it is parsed
+  std::size_t lines = 0;
+  // the first failing record: its exception and line within the batch
+  std::exception_ptr error;
+  std::size_t error_line = 0;
+  // set by the worker once the fields above are final
+  std::promise<void> parsed;
+  // the worker's next batch, given by the calling thread
+  std::promise<Batch*> next;
+  std::future<Batch*> following;
+};
+
+
+namespace {
+
+// rethrow a batch error, moving JSONExceptions to the record's line
+[[noreturn]] void rethrow(std::exception_ptr error, std::size_t line)
+{
+  try {
+    std::rethrow_exception(error);
+  } catch (const JSONException& e) {
+    throw e.at_line(static_cast<int>(line));
+  }
+}
+
+} // namespace
+
+
+NDJSONReader::NDJSONReader(unsigned thread_count, Order delivery)
+  : threads(thread_count), order(delivery), batch_size(DEFAULT_BATCH_SIZE)
+{
+  if (!threads) threads = std::thread::hardware_concurrency();
+  if (!threads) threads = 1;
+}
+
+
+void NDJSONReader::set_batch_size(std::size_t bytes)
+{
+  batch_size = bytes ? bytes : 1;
+}
+
+
+void NDJSONReader::read(std::string_view input, const Callback& callback)
+{
+  std::size_t pos = 0;
+  run([&](Batch& batch) {
+    if (pos == input.size()) return false;
+    std::size_t end = input.size();
+    if (end - pos > batch_size) {
+      // extend to the end of the line
+      const char* eol = static_cast<const char*>(
+        std::memchr(input.data() + pos + batch_size, '\n', end - pos - batch_size));
+      if (eol) end = eol - input.data() + 1;
+    }
+    batch.text = input.substr(pos, end - pos);
+    batch.offset = pos;
+    pos = end;
+    return true;
+  }, callback);
+}
+
+
+void NDJSONReader::read(std::istream& input, const Callback& callback)
+{
+  // the partial last line of each block is carried into the next one
+  std::string carry;
+  std::size_t offset = 0;
+  run([&](Batch& batch) {
+    std::shared_ptr<std::string> block = std::make_shared<std::string>();
+    block->swap(carry);
+    while (input) {
+      std::size_t kept = block->size();
+      block->resize(kept + batch_size);
+      input.read(&(*block)[kept], batch_size);
+      block->resize(kept + input.gcount());
+      // only the new data can hold a newline
+      std::size_t eol = std::string_view(*block).substr(kept).rfind('\n');
+      if (eol != std::string::npos) {
+        carry.assign(*block, kept + eol + 1, std::string::npos);
+        block->resize(kept + eol + 1);
+        break;
+      }
+      // otherwise the line is longer than a batch: read on
+    }
+    if (block->empty()) return false;
+    batch.text = *block;
+    batch.offset = offset;
+    batch.owner = block;
+    offset += block->size();
+    return true;
+  }, callback);
+}
+
+
+void NDJSONReader::parse(Batch& batch, const Callback* deliver)
+{
+  const char* p = batch.text.data();
+  const char* end = p + batch.text.size();
+  while (p != end) {
+    const char* eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    if (!eol) eol = end;
+    if (!is_blank(p, eol)) {
+      try {
+        std::unique_ptr<JSONDocument> doc(new JSONDocument);
+        Lexer lexer(p, eol - p);
+        Parser parser(lexer);
+        parser.parse(*doc);
+        if (batch.owner) doc->source = batch.owner;
+        std::size_t offset = batch.offset + (p - batch.text.data());
+        if (deliver)
+          (*deliver)(*doc, offset);
+        else
+          batch.records.emplace_back(std::move(doc), offset);
+      } catch (...) {
+        batch.error = std::current_exception();
+        batch.error_line = batch.lines;
+        return;
+      }
+    }
+    if (eol == end) break;
+    ++batch.lines;
+    p = eol + 1;
+  }
+}
+
+
+void NDJSONReader::run(const std::function<bool(Batch&)>& next_batch, const Callback& callback)
+{
+  const Callback* deliver = order == UNORDERED ? &callback : nullptr;
+  // lines before the oldest batch that has not been delivered
+  std::size_t line = 1;
+
+  if (threads == 1) {
+    Batch batch;
+    while (next_batch(batch)) {
+      parse(batch, &callback);
+      if (batch.error) rethrow(batch.error, line + batch.error_line);
+      line += batch.lines;
+      batch = Batch();
+    }
+    return;
+  }
+
+  // a fixed set of workers, started once; batch k goes to worker
+  // k % threads, and each batch hands its worker the next one (nullptr to
+  // stop). The calling thread reads the input and delivers the oldest
+  // batch once it is parsed. Keeping twice as many batches in flight as
+  // threads lets the workers carry on while the oldest one finishes, and
+  // keeps a worker's previous batch in flight until its next is handed on
+  std::deque<std::pair<std::unique_ptr<Batch>, std::future<void>>> in_flight;
+  struct Workers
+  {
+    std::vector<std::future<void>> tasks;
+    // each worker's latest batch, which has not been handed a next one
+    std::vector<Batch*> latest;
+    // let each worker finish the batches it was given and end; done at
+    // the end of the input, or however run() ends (before in_flight is
+    // released, and while the latest batches are still in it)
+    void stop()
+    {
+      for (Batch* batch : latest)
+        batch->next.set_value(nullptr);
+      latest.clear();
+    }
+    ~Workers()
+    {
+      stop();
+      for (std::future<void>& task : tasks)
+        task.wait();
+    }
+  } workers;
+  const std::size_t max_in_flight = 2 * threads;
+  std::size_t count = 0;
+  bool more = true;
+  while (true) {
+    while (more && in_flight.size() < max_in_flight) {
+      std::unique_ptr<Batch> batch(new Batch);
+      more = next_batch(*batch);
+      if (!more) {
+        // the latest batches are released once delivered
+        workers.stop();
+        break;
+      }
+      Batch* handed = batch.get();
+      handed->following = handed->next.get_future();
+      in_flight.emplace_back(std::move(batch), handed->parsed.get_future());
+      std::size_t worker = count++ % threads;
+      if (worker == workers.tasks.size()) {
+        workers.latest.push_back(handed);
+        workers.tasks.push_back(std::async(std::launch::async, [handed, deliver] {
+          for (Batch* b = handed; b;) {
+            parse(*b, deliver);
+            // b may be released as soon as it is marked parsed
+            std::future<Batch*> following = std::move(b->following);
+            b->parsed.set_value();
+            b = following.get();
+          }
+        }));
+      } else {
+        workers.latest[worker]->next.set_value(handed);
+        workers.latest[worker] = handed;
+      }
+    }
+    if (in_flight.empty()) break;
+
+    in_flight.front().second.get();
+    Batch& oldest = *in_flight.front().first;
+    for (auto& record : oldest.records)
+      callback(*record.first, record.second);
+    if (oldest.error) rethrow(oldest.error, line + oldest.error_line);
+    line += oldest.lines;
+    in_flight.pop_front();
+  }
+}
+
+
+#endif // ifndef NDJSON_CPP
@@ -0,0 +1,70 @@
+#ifndef NDJSON_H
+#define NDJSON_H
+
+#include <cstddef>
+#include <functional>
+#include <istream>
+#include <string_view>
+#include "ast.h"
+
+
+//----------------------------------------------------------------------
+// Newline-delimited JSON (JSON Lines) reader
+//----------------------------------------------------------------------
+
+// Parses a sequence of records, one JSON value per line, on several
+// threads. The input is cut into batches of whole lines (finding a
+// boundary only needs a newline search near the batch size) and each
+// worker parses its batch into one JSONDocument per record. Blank lines
+// are skipped.
+//
+// ORDERED delivers the records in input order on the calling thread.
+// UNORDERED calls the callback on the worker threads as soon as a record
+// is parsed, concurrently, so the callback must be thread-safe; nothing is
+// held back behind a slow batch. Either way the first malformed record in
+// input order is rethrown from read() as a JSONException at its line in
+// the input, after every record before it has been delivered (UNORDERED
+// may also have delivered some records after it). An exception thrown by
+// the callback ends read() the same way.
+class NDJSONReader
+{
+  public:
+    enum Order { ORDERED, UNORDERED };
+
+    // a record and the byte offset of its line in the input; the document
+    // is released when the callback returns
+    using Callback = std::function<void(JSONDocument&, std::size_t offset)>;
+
+    static constexpr std::size_t DEFAULT_BATCH_SIZE = 1 << 20;
+
+    // threads = 0 uses one thread per hardware thread; with one thread the
+    // records are parsed on the calling thread
+    explicit NDJSONReader(unsigned threads = 0, Order order = ORDERED);
+
+    // approximate input bytes per batch (the unit of work of a thread)
+    void set_batch_size(std::size_t bytes);
+
+    // parse every record of a buffer (which must outlive the call)
+    void read(std::string_view input, const Callback& callback);
+
+    // parse every record of a stream, read a batch at a time
+    void read(std::istream& input, const Callback& callback);
+
+  private:
+    unsigned threads;
+    Order order;
+    std::size_t batch_size;
+
+    struct Batch;
+
+    // parse the records of a batch, keeping them in the batch or (with a
+    // callback) delivering them as they are parsed
+    static void parse(Batch& batch, const Callback* deliver);
+
+    // parse the batches from next_batch in parallel and deliver the
+    // results
+    void run(const std::function<bool(Batch&)>& next_batch, const Callback& callback);
+};
+
+
+#endif // ifndef NDJSON_H
@@ -0,0 +1,190 @@
+#ifndef NUMBER_CPP
+#define NUMBER_CPP
+
+#include <charconv>
+#include <limits>
+#include "number.h"
+
+
+namespace {
+
+// a JSON number as (-1)^negative * digits * 10^exponent, with leading and
+// trailing zeros removed from digits
+struct Decimal
+{
+  bool negative = false;
+  std::uint64_t digits = 0;
+  int digit_count = 0;      // significant digits
+  bool digits_overflow = false;
+  long exponent = 0;
+};
+
+const long MAX_EXPONENT = 1000000;
+
+Decimal decompose(std::string_view lexeme)
+{
+  Decimal d;
+  const char* p = lexeme.data();
+  const char* end = p + lexeme.size();
+  if (p != end && *p == '-') {
+    d.negative = true;
+    ++p;
+  }
+  const char* int_begin = p;
+  while (p != end && *p >= '0' && *p <= '9') ++p;
+  const char* int_end = p;
+  const char* frac_begin = p;
+  const char* frac_end = p;
+  if (p != end && *p == '.') {
+    frac_begin = ++p;
+    while (p != end && *p >= '0' && *p <= '9') ++p;
+    frac_end = p;
+  }
+  long exp = 0;
+  if (p != end && (*p == 'e' || *p == 'E')) {
+    ++p;
+    bool exp_negative = false;
+    if (p != end && (*p == '-' || *p == '+')) exp_negative = *p++ == '-';
+    for (; p != end; ++p) {
+      if (exp < MAX_EXPONENT) exp = exp * 10 + (*p - '0');
+    }
+    if (exp_negative) exp = -exp;
+  }
+
+  // the significant digits are int part followed by frac part
+  long int_len = int_end - int_begin;
+  long total = int_len + (frac_end - frac_begin);
+  auto digit_at = [&](long i) {
+    return i < int_len ? int_begin[i] : frac_begin[i - int_len];
+  };
+  d.exponent = exp - (frac_end - frac_begin);
+  long first = 0;
+  long last = total;
+  while (last > first && digit_at(last - 1) == '0') {
+    --last;
+    ++d.exponent;
+  }
+  while (first < last && digit_at(first) == '0') ++first;
+
+  const std::uint64_t limit = std::numeric_limits<std::uint64_t>::max();
+  for (long i = first; i < last; ++i) {
+    unsigned int digit = digit_at(i) - '0';
+    if (d.digits > (limit - digit) / 10) {
+      d.digits_overflow = true;
+      break;
+    }
+    d.digits = d.digits * 10 + digit;
+  }
+  d.digit_count = static_cast<int>(last - first);
+  return d;
+}
+
+// whether odd * 2^k fits a double's 53-bit significand
+inline bool fits_significand(std::uint64_t m)
+{
+  while (m && !(m & 1)) m >>= 1;
+  return m < (std::uint64_t(1) << 53);
+}
+
+NumberStatus integer_status(const Decimal& d, std::uint64_t& magnitude)
+{
+  magnitude = 0;
+  if (!d.digit_count) return NUMBER_EXACT;
+  // trailing zeros are stripped, so a negative exponent means a fraction
+  if (d.exponent < 0) return NUMBER_INEXACT;
+  if (d.digits_overflow) return NUMBER_OVERFLOW;
+  std::uint64_t m = d.digits;
+  for (long i = 0; i < d.exponent; ++i) {
+    if (m > std::numeric_limits<std::uint64_t>::max() / 10) return NUMBER_OVERFLOW;
+    m *= 10;
+  }
+  magnitude = m;
+  return NUMBER_EXACT;
+}
+
+NumberStatus double_status(std::string_view lexeme, const Decimal& d, double& value)
+{
+  // Clinger's fast path: both the digits and the power of ten are exact
+  // doubles, so one multiplication or division rounds correctly
+  static const double powers[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+  if (!d.digits_overflow && d.digits <= (std::uint64_t(1) << 53) &&
+      d.exponent >= -22 && d.exponent <= 22) {
+    value = static_cast<double>(d.digits);
+    value = d.exponent < 0 ? value / powers[-d.exponent] : value * powers[d.exponent];
+    if (d.negative) value = -value;
+  } else {
+    std::from_chars_result r = std::from_chars(lexeme.data(), lexeme.data() + lexeme.size(), value);
+    if (r.ec == std::errc::result_out_of_range) {
+      // decide between underflow and overflow from the decimal magnitude
+      if (d.exponent + d.digit_count <= 0) {
+        value = d.negative ? -0.0 : 0.0;
+        return NUMBER_INEXACT;
+      }
+      value = d.negative ? -std::numeric_limits<double>::infinity()
+                         : std::numeric_limits<double>::infinity();
+      return NUMBER_OVERFLOW;
+    }
+  }
+  if (!d.digit_count) return NUMBER_EXACT;
+  if (d.digits_overflow) return NUMBER_INEXACT;
+
+  // digits * 10^e = (digits * 5^e) * 2^e, exact when the odd part fits
+  std::uint64_t m = d.digits;
+  if (d.exponent >= 0) {
+    for (long i = 0; i < d.exponent; ++i) {
+      if (m > std::numeric_limits<std::uint64_t>::max() / 5) return NUMBER_INEXACT;
+      m *= 5;
+    }
+  } else {
+    if (d.exponent < -27) return NUMBER_INEXACT; // 5^28 does not fit 64 bits
+    std::uint64_t p5 = 1;
+    for (long i = 0; i < -d.exponent; ++i) p5 *= 5;
+    if (m % p5) return NUMBER_INEXACT;
+    m /= p5;
+  }
+  return fits_significand(m) ? NUMBER_EXACT : NUMBER_INEXACT;
+}
+
+} // namespace
+
+
+NumberStatus parse_json_integer(std::string_view lexeme, bool& negative,
+                                std::uint64_t& magnitude)
+{
+  Decimal d = decompose(lexeme);
+  negative = d.negative;
+  return integer_status(d, magnitude);
+}
+
+
+NumberStatus parse_json_double(std::string_view lexeme, double& value)
+{
+  return double_status(lexeme, decompose(lexeme), value);
+}
+
+
+NumberStatus parse_json_number(std::string_view lexeme, bool& negative,
+                               std::uint64_t& magnitude, double& value,
+                               NumberStatus& double_conversion)
+{
+  Decimal d = decompose(lexeme);
+  negative = d.negative;
+  NumberStatus status = integer_status(d, magnitude);
+  if (status != NUMBER_EXACT)
+    double_conversion = double_status(lexeme, d, value);
+  return status;
+}
+
+
+NumberStatus integer_to_double(bool negative, std::uint64_t magnitude, double& value)
+{
+  value = static_cast<double>(magnitude);
+  if (negative) value = -value;
+  return fits_significand(magnitude) ? NUMBER_EXACT : NUMBER_INEXACT;
+}
+
+
+#endif // ifndef NUMBER_CPP
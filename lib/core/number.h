@@ -0,0 +1,41 @@
+#ifndef NUMBER_H
+#define NUMBER_H
+
+#include <cstdint>
+#include <string_view>
+
+
+//----------------------------------------------------------------------
+// Numeric conversion of NUMBER_VAL lexemes
+//----------------------------------------------------------------------
+
+// result of converting a number to a requested type
+enum NumberStatus {
+  NUMBER_EXACT,    // the converted value equals the written value
+  NUMBER_INEXACT,  // rounded (double) or has a fractional part (integers)
+  NUMBER_OVERFLOW  // out of range for the requested type
+};
+
+// convert a valid JSON number lexeme to a sign and 64-bit magnitude.
+// Exponents are applied, so "1e3" and "2.50e1" are exact integers
+NumberStatus parse_json_integer(std::string_view lexeme, bool& negative,
+                                std::uint64_t& magnitude);
+
+// convert a valid JSON number lexeme to the nearest double (std::from_chars,
+// an Eisel-Lemire implementation in current standard libraries). Exactness
+// is judged conservatively: NUMBER_INEXACT means the double may differ from
+// the written value. Underflow gives a signed zero and NUMBER_INEXACT
+NumberStatus parse_json_double(std::string_view lexeme, double& value);
+
+// both conversions at once: returns the integer status and, if that is not
+// NUMBER_EXACT, also converts to value/double_status (the lexeme is only
+// scanned once)
+NumberStatus parse_json_number(std::string_view lexeme, bool& negative,
+                               std::uint64_t& magnitude, double& value,
+                               NumberStatus& double_status);
+
+// exactness of the conversion of an integer magnitude to double
+NumberStatus integer_to_double(bool negative, std::uint64_t magnitude, double& value);
+
+
+#endif // ifndef NUMBER_H
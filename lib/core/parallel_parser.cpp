@@ -0,0 +1,109 @@
+#ifndef PARALLEL_PARSER_CPP
+#define PARALLEL_PARSER_CPP
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "parallel_parser.h"
+#include "structural_index.h"
+#include "json_string.h"
+#include "lexer.h"
+#include "parser.h"
+
+
+namespace {
+
+void parse_serial(std::string_view input, JSONDocument& doc)
+{
+  Lexer lexer(input);
+  Parser parser(lexer);
+  parser.parse(doc);
+}
+
+} // namespace
+
+
+ParallelParser::ParallelParser(unsigned thread_count)
+  : threads(thread_count), chunk_size(DEFAULT_CHUNK_SIZE)
+{
+  if (!threads) threads = std::thread::hardware_concurrency();
+  if (!threads) threads = 1;
+}
+
+
+void ParallelParser::set_chunk_size(std::size_t bytes)
+{
+  chunk_size = bytes ? bytes : 1;
+}
+
+
+void ParallelParser::parse(std::string_view input, JSONDocument& doc)
+{
+  if (threads == 1 || input.size() < 2 * chunk_size) {
+    parse_serial(input, doc);
+    return;
+  }
+
+  // [ piece , piece , ... ] with only whitespace around the brackets
+  std::vector<StructuralIndex::Split> splits = StructuralIndex::split_array(input, chunk_size);
+  const char* begin = input.data();
+  if (splits.size() < 3 || !is_blank(begin, begin + splits.front().offset) ||
+      !is_blank(begin + splits.back().offset + 1, begin + input.size())) {
+    parse_serial(input, doc);
+    return;
+  }
+
+  // each piece is the text between two splits, starting just after the
+  // first; the tasks take pieces in turn
+  std::size_t count = splits.size() - 1;
+  std::vector<std::unique_ptr<JSONDocument>> pieces(count);
+  std::atomic<std::size_t> next(0);
+  std::atomic<bool> failed(false);
+  auto work = [&]() {
+    for (std::size_t i; !failed && (i = next++) < count;) {
+      const StructuralIndex::Split& from = splits[i];
+      std::size_t end = splits[i + 1].offset;
+      try {
+        pieces[i].reset(new JSONDocument);
+        Lexer lexer(begin + from.offset + 1, end - from.offset - 1, from.line, from.column + 1);
+        Parser parser(lexer);
+        parser.parse_elements(*pieces[i]);
+      } catch (...) {
+        failed = true;
+      }
+    }
+  };
+  std::vector<std::future<void>> tasks;
+  for (unsigned t = 1; t < threads && t < count; ++t)
+    tasks.push_back(std::async(std::launch::async, work));
+  work();
+  for (std::future<void>& task : tasks) task.get();
+
+  if (failed) {
+    parse_serial(input, doc);
+    return;
+  }
+
+  // stitch the elements into one array
+  std::size_t total = 0;
+  for (std::unique_ptr<JSONDocument>& piece : pieces)
+    total += static_cast<Array*>(piece->root)->values.size();
+  Array* root = doc.arena.create<Array>();
+  root->values.count = total;
+  root->values.items = static_cast<RValue**>(doc.arena.allocate(total * sizeof(RValue*), alignof(RValue*)));
+  RValue** out = root->values.items;
+  for (std::unique_ptr<JSONDocument>& piece : pieces) {
+    for (RValue* value : static_cast<Array*>(piece->root)->values)
+      *out++ = value;
+    doc.arena.absorb(piece->arena);
+  }
+  const StructuralIndex::Split& close = splits.back();
+  root->rbracket_token = Token(RBRACKET, std::string_view(begin + close.offset, 1), close.line, close.column);
+  doc.root = root;
+  doc.source.reset();
+}
+
+
+#endif // ifndef PARALLEL_PARSER_CPP
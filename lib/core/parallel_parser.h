@@ -0,0 +1,43 @@
+#ifndef PARALLEL_PARSER_H
+#define PARALLEL_PARSER_H
+
+#include <cstddef>
+#include <string_view>
+#include "ast.h"
+
+
+//----------------------------------------------------------------------
+// Parallel parsing of one large top-level array
+//----------------------------------------------------------------------
+
+// Builds the same JSONDocument as Parser, using several threads when the
+// document is one large array. A structural pre-scan
+// (StructuralIndex::split_array) cuts the array between elements into
+// pieces of about chunk_size bytes; the pieces are parsed concurrently,
+// each into its own arena, and the elements are stitched into a single
+// Array in input order, the arenas moving into the document's. Tokens
+// keep their line and column in the whole input. Any other document, or
+// an array too small to cut, is parsed serially, and so is the whole
+// input again if any piece fails, so errors are exactly Parser's. Like
+// Lexer(std::string_view), the tokens point into input, which must
+// outlive the document.
+class ParallelParser
+{
+  public:
+    static constexpr std::size_t DEFAULT_CHUNK_SIZE = 4 << 20;
+
+    // threads = 0 uses one thread per hardware thread
+    explicit ParallelParser(unsigned threads = 0);
+
+    // approximate input bytes per piece
+    void set_chunk_size(std::size_t bytes);
+
+    void parse(std::string_view input, JSONDocument& doc);
+
+  private:
+    unsigned threads;
+    std::size_t chunk_size;
+};
+
+
+#endif // ifndef PARALLEL_PARSER_H
@@ -1,15 +1,29 @@
 #ifndef PARSER_CPP
 #define PARSER_CPP
 
+#include <string>
 #include "parser.h"
+#include "dom_builder.h"
 
 
 // constructor
-Parser::Parser(const Lexer& json_lexer) : lexer(json_lexer)
+Parser::Parser(const Lexer& json_lexer) : lexer(json_lexer), max_depth(DEFAULT_MAX_DEPTH), symbols(nullptr)
 {
 }
 
 
+void Parser::set_max_depth(std::size_t depth)
+{
+	max_depth = depth;
+}
+
+
+void Parser::set_symbol_table(SymbolTable* symbol_table)
+{
+	symbols = symbol_table;
+}
+
+
 // Helper functions
 
 void Parser::advance()
@@ -18,7 +32,7 @@ void Parser::advance()
 }
 
 
-void Parser::eat(TokenType t, std::string err_msg)
+void Parser::eat(TokenType t, const char* err_msg)
 {
 	if (curr_token.type() == t)
 		advance();
@@ -29,7 +43,7 @@ void Parser::eat(TokenType t, std::string err_msg)
 
 void Parser::error(std::string err_msg)
 {
-	std::string s = err_msg + "found '" + curr_token.lexeme() + "'";
+	std::string s = err_msg + "found '" + std::string(curr_token.lexeme()) + "'";
 	this->base_error(s);
 }
 
@@ -43,146 +57,160 @@ void Parser::base_error(std::string err_msg)
 }
 
 
-// Recursive-decent functions
+// Entry points
 
 void Parser::parse(JSONDocument& doc)
 {
-	advance();
-	rvalue(doc.root);
-	eat(EOS, "Unexpected token: expected end-of-file, ");
-}
-
-
-// Values
-
-void Parser::json(JSON& node)
-{
-	eat(LBRACE, "Unexpected token: expected '{', ");
-	records(node.records);
-	eat(RBRACE, "Unexpected token: expected ',', ");
+	doc.source = lexer.input_owner();
+	DOMBuilder builder(doc, !lexer.stable_tokens(), symbols);
+	document(builder);
 }
 
-void Parser::records(std::list<Record*>& records)
+void Parser::parse(Tape& tape)
 {
-	if(curr_token.type() == RBRACE) return;
-
-	while(1)
-	{
-		Record* r = new Record;
-		record(*r);
-		records.push_back(r);
-		if(curr_token.type() != COMMA) {
-			break;
-		}
-		advance();
-	}
+	tape.source = lexer.input_owner();
+	tape.source_base = lexer.input().data();
+	tape.entries.clear();
+	TapeBuilder builder(tape, !lexer.stable_tokens());
+	document(builder);
 }
 
-void Parser::record(Record& node)
+void Parser::parse(Handler& handler)
 {
-	node.key = curr_token;
-	kval();
-	eat(COLON, "Unexpected token: expected ':', ");
-	rvalue(node.value);
-}
-
-void Parser::array(Array& node)
-{
-	eat(LBRACKET, "Unexpected token: expected '[', "); // Should never throw
-	values(node.values);
-	eat(RBRACKET, "Unexpected token: expected ']', ");
+	document(handler);
 }
 
-void Parser::values(std::list<RValue*>& vals)
+void Parser::parse_elements(JSONDocument& doc)
 {
-	if(curr_token.type() == RBRACKET) return;
-
+	doc.source = lexer.input_owner();
+	DOMBuilder builder(doc, !lexer.stable_tokens(), symbols);
+	// the array the elements belong to counts towards the depth
+	containers.assign(1, '[');
+	advance();
+	builder.start_array(curr_token);
 	while(1)
 	{
-		RValue* r;
-		rvalue(r);
-		vals.push_back(r);
+		rvalue(builder);
 		if(curr_token.type() != COMMA) {
 			break;
 		}
 		advance();
 	}
+	if(curr_token.type() != EOS)
+		error("Unexpected token: expected ',', ");
+	builder.end_array(curr_token);
 }
 
-void Parser::simple(SimpleRValue& node)
+
+// Descent functions
+
+template<typename H>
+void Parser::document(H& handler)
 {
-	node.value = curr_token;
-	pval();
-	switch(node.value.type())
-	{
-		case LITERAL_VAL:
-			node.type = LITERAL_TYPE;
-			break;
-		case NUMBER_VAL:
-			node.type = NUMBER_TYPE;
-			break;
-		case STRING_VAL:
-			node.type = STRING_TYPE;
-			break;
-		default:
-			// unreachable
-			error("Unexpected token: ");
-			break;
-	}
+	containers.clear();
+	advance();
+	rvalue(handler);
+	eat(EOS, "Unexpected token: expected end-of-file, ");
+	handler.end_document();
 }
 
-void Parser::rvalue(RValue*& rval)
+template<typename H>
+void Parser::rvalue(H& handler)
 {
-	switch(curr_token.type())
+	// containers below base are open in the caller
+	const std::size_t base = containers.size();
+	while(1)
 	{
-		case LBRACE:
+		// a scalar, or the start of a container
+		switch(curr_token.type())
 		{
-			JSON* node = new JSON;
-			json(*node);
-			rval = node;
-			break;
+			case LBRACE:
+				open(handler);
+				if(curr_token.type() == RBRACE) {
+					handler.end_object(curr_token);
+					advance();
+					break;
+				}
+				containers.push_back('{');
+				key(handler);
+				continue;
+			case LBRACKET:
+				open(handler);
+				if(curr_token.type() == RBRACKET) {
+					handler.end_array(curr_token);
+					advance();
+					break;
+				}
+				containers.push_back('[');
+				continue;
+			case STRING_VAL:
+				handler.string_value(curr_token);
+				advance();
+				break;
+			case NUMBER_VAL:
+				handler.number_value(curr_token);
+				advance();
+				break;
+			case LITERAL_VAL:
+				handler.literal_value(curr_token);
+				advance();
+				break;
+			default:
+				error("Unexpected token: expected value, ");
 		}
-		case LBRACKET:
+		// a value is complete: go on to the next element, or close every
+		// container it completes
+		while(containers.size() > base)
 		{
-			Array* node = new Array;
-			array(*node);
-			rval = node;
-			break;
-		}
-		default:
-		{
-			SimpleRValue* node = new SimpleRValue;
-			simple(*node);
-			rval = node;
-			break;
+			if(curr_token.type() == COMMA)
+			{
+				advance();
+				if(containers.back() == '{')
+					key(handler);
+				break;
+			}
+			if(containers.back() == '{')
+			{
+				if(curr_token.type() != RBRACE)
+					error("Unexpected token: expected ',', ");
+				handler.end_object(curr_token);
+			}
+			else
+			{
+				if(curr_token.type() != RBRACKET)
+					error("Unexpected token: expected ']', ");
+				handler.end_array(curr_token);
+			}
+			advance();
+			containers.pop_back();
 		}
+		if(containers.size() == base)
+			return;
 	}
 }
 
-
-// Type checks
-void Parser::kval()
+// enter the object or array at the current token
+template<typename H>
+void Parser::open(H& handler)
 {
-	if(curr_token.type() == STRING_VAL)
-	{
-		advance();
-	} else {
-		error("Unexpected token: expected string, ");
-	}
+	if(max_depth && containers.size() >= max_depth)
+		error("Maximum nesting depth of " + std::to_string(max_depth) + " exceeded, ");
+	if(curr_token.type() == LBRACE)
+		handler.start_object(curr_token);
+	else
+		handler.start_array(curr_token);
+	advance();
 }
 
-void Parser::pval()
+// an object member's key and colon
+template<typename H>
+void Parser::key(H& handler)
 {
-	switch(curr_token.type())
-	{
-		case LITERAL_VAL:
-		case NUMBER_VAL:
-		case STRING_VAL:
-			advance();
-			break;
-		default:
-			error("Unexpected token: expected value, ");
-	}
+	if(curr_token.type() != STRING_VAL)
+		error("Unexpected token: expected string, ");
+	handler.key(curr_token);
+	advance();
+	eat(COLON, "Unexpected token: expected ':', ");
 }
 
 
@@ -1,43 +1,72 @@
 #ifndef PARSER_H
 #define PARSER_H
 
+#include <cstddef>
+#include <vector>
 #include "token.h"
 #include "json_exception.h"
 #include "ast.h"
+#include "tape.h"
 #include "lexer.h"
+#include "handler.h"
+#include "symbol_table.h"
 
 
 class Parser
 {
 public:
-	// create a new recursive descent parser
+	// containers may nest this deep by default
+	static constexpr std::size_t DEFAULT_MAX_DEPTH = 1024;
+
+	// create a new parser
 	Parser(const Lexer&);
 
-	// run the parser
+	// fail with a JSONException on a container nested deeper than
+	// max_depth (0 for no limit; the parse itself never recurses, but
+	// recursive visitors such as Printer do)
+	void set_max_depth(std::size_t max_depth);
+
+	// intern the keys of the documents built from now on in symbols
+	// (nullptr to stop), which must outlive them; tapes and handlers still
+	// see the lexer's tokens
+	void set_symbol_table(SymbolTable* symbols);
+
+	// run the parser, building a tree
 	void parse(JSONDocument&);
 
+	// run the parser, emitting a flat tape instead of an AST
+	void parse(Tape&);
+
+	// run the parser, reporting each value to the handler as it is read
+	// (nothing is kept, so memory does not grow with the input)
+	void parse(Handler&);
+
+	// parse comma-separated values up to the end of the input into an
+	// Array as the document root: one piece of a larger array cut between
+	// elements (see ParallelParser)
+	void parse_elements(JSONDocument&);
+
 private:
 	Lexer lexer;
 	Token curr_token;
+	std::size_t max_depth;
+	SymbolTable* symbols;
+	// '{' or '[' for every open container, kept between parses
+	std::vector<char> containers;
 
 	// helper functions
 	void advance();
-	void eat(TokenType t, std::string);
+	void eat(TokenType t, const char*);
 	void error(std::string);
 	void base_error(std::string);
 
-	// recursive descent functions
-    void json(JSON&);
-    void records(std::list<Record*>&);
-    void record(Record&);
-    void array(Array&);
-	void values(std::list<RValue*>&);
-    void simple(SimpleRValue&);
-    void rvalue(RValue*&);
-
-	// Type checks
-    void kval();
-    void pval();
+	// descent functions, instantiated for the builders directly and for
+	// Handler through its virtual interface. rvalue() parses a whole value
+	// with an explicit stack of open containers instead of recursing
+	template<typename H> void document(H&);
+	template<typename H> void rvalue(H&);
+	template<typename H> void open(H&);
+	template<typename H> void key(H&);
 };
 
 
@@ -0,0 +1,366 @@
+#ifndef PATH_QUERY_CPP
+#define PATH_QUERY_CPP
+
+#include <charconv>
+#include "path_query.h"
+#include "json_string.h"
+#include "parser.h"
+
+
+namespace {
+
+[[noreturn]] void invalid_path(std::string_view path, const char* msg)
+{
+  throw JSONException(SYNTAX, "invalid path '" + std::string(path) + "': " + msg);
+}
+
+void syntax_error(const std::string& msg, const Token& t)
+{
+  throw JSONException(SYNTAX, msg + "found '" + std::string(t.lexeme()) + "'", t.line(), t.column());
+}
+
+// an array index as RFC 6901 writes it (no sign, no leading zeros)
+bool parse_index(std::string_view text, std::size_t& index)
+{
+  if (text.empty() || (text.size() > 1 && text[0] == '0')) return false;
+  auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), index);
+  return ec == std::errc() && end == text.data() + text.size();
+}
+
+} // namespace
+
+
+// the progress of one evaluation
+struct PathQuery::Walk
+{
+  // one path's progress at one level: the step the next child must match
+  struct State
+  {
+    std::uint32_t path;
+    std::uint32_t step;
+    // a name or index step already matched a child of this value
+    bool consumed;
+  };
+
+  const PathQuery& query;
+  // the states of every level being walked, innermost last
+  std::vector<State> states;
+  // the paths a child completes
+  std::vector<std::uint32_t> completed;
+  // singular paths not matched yet, and whether any path is not singular
+  std::size_t remaining = 0;
+  bool open_ended = false;
+
+  explicit Walk(const PathQuery& q) : query(q)
+  {
+    for (const Path& p : q.paths) {
+      if (p.singular) ++remaining;
+      else open_ended = true;
+    }
+  }
+
+  // nothing more can match
+  bool done() const
+  {
+    return !open_ended && !remaining;
+  }
+
+  void push(std::size_t first, std::uint32_t path, std::uint32_t step)
+  {
+    for (std::size_t i = first; i < states.size(); ++i)
+      if (states[i].path == path && states[i].step == step) return;
+    states.push_back(State{path, step, false});
+  }
+
+  // the states of the root, and the paths it completes
+  void start()
+  {
+    for (std::uint32_t p = 0; p < query.paths.size(); ++p) {
+      if (query.paths[p].steps.empty())
+        complete(p);
+      else
+        states.push_back(State{p, 0, false});
+    }
+  }
+
+  void complete(std::uint32_t path)
+  {
+    for (std::uint32_t p : completed)
+      if (p == path) return;
+    completed.push_back(path);
+    if (query.paths[path].singular) --remaining;
+  }
+
+  // advance the states from first on to a child (a member named key in
+  // an object, or element index), pushing the child's states after them
+  // and filling completed; false if nothing needs to look into the child
+  bool advance(std::size_t first, const Token* key, std::size_t index)
+  {
+    std::size_t end = states.size();
+    completed.clear();
+    for (std::size_t i = first; i < end; ++i) {
+      State s = states[i];
+      const Path& path = query.paths[s.path];
+      const Step& step = path.steps[s.step];
+      if (step.descendant)
+        push(end, s.path, s.step);
+      if (s.consumed) continue;
+      bool match = step.wildcard
+        || (key ? step.has_name && json_string_equals(key->lexeme(), step.name)
+                : step.has_index && step.index == index);
+      if (!match) continue;
+      if (!step.wildcard) states[i].consumed = true;
+      if (s.step + 1 == path.steps.size())
+        complete(s.path);
+      else
+        push(end, s.path, s.step + 1);
+    }
+    return states.size() > end;
+  }
+};
+
+
+//----------------------------------------------------------------------
+// Compiling paths
+//----------------------------------------------------------------------
+
+std::size_t PathQuery::add(std::string_view path)
+{
+  Path compiled;
+  if (!path.empty() && path[0] == '$')
+    parse_jsonpath(path, compiled);
+  else
+    parse_pointer(path, compiled);
+  for (const Step& s : compiled.steps)
+    if (s.wildcard || s.descendant) compiled.singular = false;
+  paths.push_back(std::move(compiled));
+  return paths.size() - 1;
+}
+
+
+std::size_t PathQuery::size() const
+{
+  return paths.size();
+}
+
+
+void PathQuery::parse_pointer(std::string_view path, Path& compiled) const
+{
+  if (path.empty()) return;
+  if (path[0] != '/') invalid_path(path, "a JSON Pointer starts with '/'");
+  std::size_t i = 1;
+  while (1) {
+    Step step;
+    step.has_name = true;
+    std::size_t end = path.find('/', i);
+    std::string_view token = path.substr(i, end == std::string_view::npos ? std::string_view::npos : end - i);
+    for (std::size_t j = 0; j < token.size(); ++j) {
+      if (token[j] != '~') {
+        step.name += token[j];
+      } else if (j + 1 < token.size() && (token[j + 1] == '0' || token[j + 1] == '1')) {
+        step.name += token[++j] == '0' ? '~' : '/';
+      } else {
+        invalid_path(path, "'~' must be followed by '0' or '1'");
+      }
+    }
+    step.has_index = parse_index(token, step.index);
+    compiled.steps.push_back(std::move(step));
+    if (end == std::string_view::npos) break;
+    i = end + 1;
+  }
+}
+
+
+void PathQuery::parse_jsonpath(std::string_view path, Path& compiled) const
+{
+  std::size_t i = 1;
+  while (i < path.size()) {
+    Step step;
+    if (path[i] == '.') {
+      if (++i < path.size() && path[i] == '.') {
+        step.descendant = true;
+        ++i;
+      }
+      if (i == path.size()) invalid_path(path, "expected a name after '.'");
+      if (path[i] == '*') {
+        step.wildcard = true;
+        ++i;
+      } else if (path[i] != '[') {
+        std::size_t end = path.find_first_of(".[", i);
+        if (end == std::string_view::npos) end = path.size();
+        if (end == i) invalid_path(path, "expected a name after '.'");
+        step.name = path.substr(i, end - i);
+        step.has_name = true;
+        i = end;
+      } else if (!step.descendant) {
+        invalid_path(path, "expected a name after '.'");
+      }
+    }
+    if (!step.wildcard && !step.has_name) {
+      if (i == path.size() || path[i] != '[') invalid_path(path, "expected '.' or '['");
+      ++i;
+      if (i < path.size() && (path[i] == '\'' || path[i] == '"')) {
+        // a quoted name, with \ escaping the quote or itself
+        char quote = path[i++];
+        while (i < path.size() && path[i] != quote) {
+          if (path[i] == '\\' && i + 1 < path.size()) ++i;
+          step.name += path[i++];
+        }
+        if (i++ == path.size()) invalid_path(path, "name is not closed");
+        step.has_name = true;
+      } else if (i < path.size() && path[i] == '*') {
+        step.wildcard = true;
+        ++i;
+      } else {
+        std::size_t end = path.find(']', i);
+        if (end == std::string_view::npos || !parse_index(path.substr(i, end - i), step.index))
+          invalid_path(path, "expected an index, a quoted name or '*' in brackets");
+        step.has_index = true;
+        i = end;
+      }
+      if (i == path.size() || path[i] != ']') invalid_path(path, "expected ']'");
+      ++i;
+    }
+    compiled.steps.push_back(std::move(step));
+  }
+}
+
+
+//----------------------------------------------------------------------
+// Evaluation over a tree
+//----------------------------------------------------------------------
+
+void PathQuery::evaluate(JSONDocument& doc, const TreeCallback& found) const
+{
+  if (!doc.root) return;
+  Walk w(*this);
+  w.start();
+  for (std::uint32_t p : w.completed)
+    found(p, *doc.root);
+  if (!w.states.empty() && !w.done())
+    walk(w, *doc.root, 0, found);
+}
+
+
+void PathQuery::walk(Walk& w, RValue& node, std::size_t states, const TreeCallback& found) const
+{
+  // a single name or index is looked up directly rather than by a scan
+  const Walk::State only = w.states[states];
+  const Step& step = paths[only.path].steps[only.step];
+  if (w.states.size() - states == 1 && !step.wildcard && !step.descendant) {
+    RValue* value = nullptr;
+    if (node.type == JSON_TYPE && step.has_name)
+      value = static_cast<JSON&>(node).find(step.name);
+    else if (node.type == ARRAY_TYPE && step.has_index && step.index < static_cast<Array&>(node).values.size())
+      value = static_cast<Array&>(node).values[step.index];
+    if (!value) return;
+    if (only.step + 1 == paths[only.path].steps.size()) {
+      w.completed.clear();
+      w.complete(only.path);
+      found(only.path, *value);
+    } else if (value->type == JSON_TYPE || value->type == ARRAY_TYPE) {
+      w.states.push_back(Walk::State{only.path, only.step + 1, false});
+      walk(w, *value, states + 1, found);
+      w.states.pop_back();
+    }
+    return;
+  }
+
+  if (node.type == JSON_TYPE) {
+    for (Record& r : static_cast<JSON&>(node).records) {
+      child(w, *r.value, &r.key, 0, states, found);
+      if (w.done()) return;
+    }
+  } else if (node.type == ARRAY_TYPE) {
+    Array& array = static_cast<Array&>(node);
+    for (std::size_t i = 0; i < array.values.size(); ++i) {
+      child(w, *array.values[i], nullptr, i, states, found);
+      if (w.done()) return;
+    }
+  }
+}
+
+
+void PathQuery::child(Walk& w, RValue& value, const Token* key, std::size_t index, std::size_t states,
+                      const TreeCallback& found) const
+{
+  std::size_t end = w.states.size();
+  bool deeper = w.advance(states, key, index);
+  for (std::uint32_t p : w.completed)
+    found(p, value);
+  if (deeper && !w.done() && (value.type == JSON_TYPE || value.type == ARRAY_TYPE))
+    walk(w, value, end, found);
+  w.states.resize(end);
+}
+
+
+//----------------------------------------------------------------------
+// Evaluation over the input text
+//----------------------------------------------------------------------
+
+void PathQuery::evaluate(std::string_view input, const TextCallback& found) const
+{
+  Walk w(*this);
+  w.start();
+  LazyValue root = LazyValue::root(input);
+  for (std::uint32_t p : w.completed)
+    found(p, root);
+  if (w.states.empty() || w.done()) return;
+  if (root.token.type() != LBRACE && root.token.type() != LBRACKET) return;
+  Lexer lexer = root.after();
+  walk(w, lexer, root.token, 0, 0, found);
+}
+
+
+void PathQuery::walk(Walk& w, Lexer& lexer, const Token& open, std::size_t states, std::size_t depth,
+                     const TextCallback& found) const
+{
+  if (depth >= Parser::DEFAULT_MAX_DEPTH)
+    throw JSONException(SYNTAX, "Maximum nesting depth of " + std::to_string(Parser::DEFAULT_MAX_DEPTH) + " exceeded",
+                        open.line(), open.column());
+  bool in_object = open.type() == LBRACE;
+  TokenType close = in_object ? RBRACE : RBRACKET;
+  const char* input_end = lexer.input().data() + lexer.input().size();
+  Token t = lexer.next_token();
+  if (t.type() == close) return;
+  for (std::size_t index = 0;; ++index) {
+    Token key;
+    if (in_object) {
+      if (t.type() != STRING_VAL)
+        syntax_error("Unexpected token: expected string, ", t);
+      key = t;
+      t = lexer.next_token();
+      if (t.type() != COLON)
+        syntax_error("Unexpected token: expected ':', ", t);
+      t = lexer.next_token();
+    }
+    LazyValue value = LazyValue::value_at(t, input_end, key);
+
+    std::size_t end = w.states.size();
+    bool deeper = w.advance(states, in_object ? &key : nullptr, index);
+    for (std::uint32_t p : w.completed)
+      found(p, value);
+    if (w.done()) return;
+    if (t.type() == LBRACE || t.type() == LBRACKET) {
+      if (deeper) {
+        // lexer is already just past the bracket
+        walk(w, lexer, t, end, depth + 1, found);
+        if (w.done()) return;
+      } else {
+        int line, column;
+        const char* p = value.value_end(line, column);
+        lexer = Lexer(p, input_end - p, line, column);
+      }
+    }
+    w.states.resize(end);
+
+    t = lexer.next_token();
+    if (t.type() == close) return;
+    if (t.type() != COMMA)
+      syntax_error(in_object ? "Unexpected token: expected ',', " : "Unexpected token: expected ']', ", t);
+    t = lexer.next_token();
+  }
+}
+
+
+#endif // ifndef PATH_QUERY_CPP
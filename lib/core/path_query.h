@@ -0,0 +1,90 @@
+#ifndef PATH_QUERY_H
+#define PATH_QUERY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "json_exception.h"
+#include "ast.h"
+#include "lazy_value.h"
+
+
+//----------------------------------------------------------------------
+// Path queries
+//----------------------------------------------------------------------
+
+// A set of paths compiled once and resolved together in one walk, over a
+// tree or directly over the input text. Paths are either RFC 6901 JSON
+// Pointers ("/Image/Thumbnail/Url", "" for the root; a token of digits
+// is an array index or a member name) or a JSONPath subset:
+//
+//   $            the root
+//   .name        a member (also ['name'] or ["name"])
+//   [3]          an array element
+//   .* [*]       every member or element
+//   ..name ..*   the same at any depth below (also ..[3], ..['name'])
+//
+// A name selects the first member with that name, as JSON::find() does,
+// and names are compared with escape sequences decoded. Matches are
+// reported in document order, each value at most once per path.
+class PathQuery
+{
+  public:
+    using TreeCallback = std::function<void(std::size_t path, RValue& value)>;
+    using TextCallback = std::function<void(std::size_t path, const LazyValue& value)>;
+
+    // compile a path and return its index (a SYNTAX JSONException if it
+    // is neither a JSON Pointer nor in the JSONPath subset)
+    std::size_t add(std::string_view path);
+
+    // number of paths added
+    std::size_t size() const;
+
+    // report every match in a tree
+    void evaluate(JSONDocument& doc, const TreeCallback& found) const;
+
+    // report every match in the input text without building a tree. Only
+    // values on the way to a match are lexed; other members and elements
+    // are passed over by matching brackets, as LazyValue does, and once
+    // every path without wildcards or descent has matched nothing further
+    // is read. Matches are cursors into input, which must outlive them
+    void evaluate(std::string_view input, const TextCallback& found) const;
+
+  private:
+    struct Step
+    {
+      std::string name;
+      std::size_t index = 0;
+      bool has_name = false;
+      bool has_index = false;
+      bool wildcard = false;
+      // matches at any depth below the current value
+      bool descendant = false;
+    };
+    struct Path
+    {
+      std::vector<Step> steps;
+      // matches at most one value
+      bool singular = true;
+    };
+    std::vector<Path> paths;
+
+    struct Walk;
+
+    void parse_pointer(std::string_view path, Path& compiled) const;
+    void parse_jsonpath(std::string_view path, Path& compiled) const;
+    // follow the states from states on into the children of a container
+    // (in the text, lexer is just past its opening bracket and is left
+    // just past its closing one, unless the walk is done)
+    void walk(Walk& w, RValue& node, std::size_t states, const TreeCallback& found) const;
+    void walk(Walk& w, Lexer& lexer, const Token& open, std::size_t states, std::size_t depth,
+              const TextCallback& found) const;
+    void child(Walk& w, RValue& value, const Token* key, std::size_t index, std::size_t states,
+               const TreeCallback& found) const;
+};
+
+
+#endif // ifndef PATH_QUERY_H
@@ -0,0 +1,414 @@
+#ifndef PUSH_PARSER_CPP
+#define PUSH_PARSER_CPP
+
+#include <cstring>
+#include "push_parser.h"
+#include "json_string.h"
+
+
+namespace {
+
+inline bool is_digit(char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+inline bool is_space(char c)
+{
+  // same set as Lexer::skipNextChar()
+  return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// characters that can continue a number or literal token
+inline bool is_number_char(char c)
+{
+  return is_digit(c) || c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-';
+}
+
+inline bool is_literal_char(char c)
+{
+  return c >= 'a' && c <= 'z';
+}
+
+} // namespace
+
+
+PushParser::PushParser(Handler& h, bool multiple, std::size_t depth)
+  : handler(h), multiple_values(multiple), max_depth(depth)
+{
+  reset();
+}
+
+
+void PushParser::reset()
+{
+  state = EXPECT_VALUE;
+  containers.clear();
+  partial = NO_PARTIAL;
+  partial_text.clear();
+  partial_escape = false;
+  line = 1;
+  column = 1;
+}
+
+
+std::size_t PushParser::depth() const
+{
+  return containers.size();
+}
+
+
+PushParser::Status PushParser::feed(std::string_view data)
+{
+  return feed(data.data(), data.size());
+}
+
+
+PushParser::Status PushParser::feed(const char* data, std::size_t size)
+{
+  const char* p = data;
+  const char* end = data + size;
+  if (partial != NO_PARTIAL) {
+    p = resume_partial(p, end);
+    if (!p) return NEED_MORE_INPUT;
+  }
+  return scan(p, end);
+}
+
+
+void PushParser::finish()
+{
+  switch (partial) {
+    case PARTIAL_STRING:
+      lexer_error("Invalid token '\"" + partial_text +
+        "': string values require an opening and closing quotation mark,", partial_line, partial_column);
+      break;
+    case PARTIAL_NUMBER:
+      partial = NO_PARTIAL;
+      number_token(partial_text, partial_line, partial_column);
+      break;
+    case PARTIAL_LITERAL:
+      partial = NO_PARTIAL;
+      literal_token(partial_text, partial_line, partial_column);
+      break;
+    default:
+      break;
+  }
+  // the end of input is the EOS token for the grammar
+  if (state != EXPECT_END && !(multiple_values && state == EXPECT_VALUE && containers.empty()))
+    token(Token(EOS, std::string_view(), line, column));
+}
+
+
+//----------------------------------------------------------------------
+// Tokens
+//----------------------------------------------------------------------
+
+PushParser::Status PushParser::scan(const char* p, const char* end)
+{
+  while (p != end) {
+    char c = *p;
+    if (is_space(c)) {
+      if (c == '\n') {
+        ++line;
+        column = 1;
+      } else {
+        ++column;
+      }
+      ++p;
+      continue;
+    }
+    int start_column = column;
+    switch (c) {
+      case '{': ++column; token(Token(LBRACE, std::string_view(p, 1), line, start_column)); ++p; continue;
+      case '}': ++column; token(Token(RBRACE, std::string_view(p, 1), line, start_column)); ++p; continue;
+      case '[': ++column; token(Token(LBRACKET, std::string_view(p, 1), line, start_column)); ++p; continue;
+      case ']': ++column; token(Token(RBRACKET, std::string_view(p, 1), line, start_column)); ++p; continue;
+      case ':': ++column; token(Token(COLON, std::string_view(p, 1), line, start_column)); ++p; continue;
+      case ',': ++column; token(Token(COMMA, std::string_view(p, 1), line, start_column)); ++p; continue;
+      case '"':
+      {
+        bool escape = false;
+        const char* close = string_end(p + 1, end, escape, line, start_column);
+        if (!close) {
+          partial = PARTIAL_STRING;
+          partial_text.assign(p + 1, end);
+          partial_escape = escape;
+          partial_line = line;
+          partial_column = start_column;
+          return NEED_MORE_INPUT;
+        }
+        column += static_cast<int>(close - p) + 1;
+        string_token(std::string_view(p + 1, close - p - 1), line, start_column);
+        p = close + 1;
+        continue;
+      }
+      default:
+        break;
+    }
+    // numbers and literals end at the first character that cannot continue
+    // them, which may be in a later chunk
+    bool number = is_digit(c) || c == '-';
+    const char* q = p + 1;
+    if (number) {
+      while (q != end && is_number_char(*q)) ++q;
+    } else {
+      while (q != end && is_literal_char(*q)) ++q;
+    }
+    if (q == end) {
+      partial = number ? PARTIAL_NUMBER : PARTIAL_LITERAL;
+      partial_text.assign(p, end);
+      partial_line = line;
+      partial_column = start_column;
+      return NEED_MORE_INPUT;
+    }
+    column += static_cast<int>(q - p);
+    if (number)
+      number_token(std::string_view(p, q - p), line, start_column);
+    else
+      literal_token(std::string_view(p, q - p), line, start_column);
+    p = q;
+  }
+  return state == EXPECT_END ? DONE : NEED_MORE_INPUT;
+}
+
+
+const char* PushParser::resume_partial(const char* p, const char* end)
+{
+  const char* q = p;
+  switch (partial) {
+    case PARTIAL_STRING:
+    {
+      q = string_end(p, end, partial_escape, partial_line, partial_column);
+      if (!q) {
+        partial_text.append(p, end);
+        return nullptr;
+      }
+      partial_text.append(p, q);
+      column += static_cast<int>(partial_text.size()) + 2;
+      partial = NO_PARTIAL;
+      string_token(partial_text, partial_line, partial_column);
+      return q + 1;
+    }
+    case PARTIAL_NUMBER:
+      while (q != end && is_number_char(*q)) ++q;
+      break;
+    default:
+      while (q != end && is_literal_char(*q)) ++q;
+      break;
+  }
+  partial_text.append(p, q);
+  if (q == end) return nullptr;
+  column += static_cast<int>(partial_text.size());
+  Partial kind = partial;
+  partial = NO_PARTIAL;
+  if (kind == PARTIAL_NUMBER)
+    number_token(partial_text, partial_line, partial_column);
+  else
+    literal_token(partial_text, partial_line, partial_column);
+  return q;
+}
+
+
+const char* PushParser::string_end(const char* p, const char* end, bool& escape,
+                                   int start_line, int start_column)
+{
+  if (escape) {
+    if (p == end) return nullptr;
+    // the escaped character (validated once the string is complete)
+    escape = false;
+    ++p;
+  }
+  while (true) {
+    p = find_string_delimiter(p, end);
+    if (p == end) return nullptr;
+    if (*p == '"') return p;
+    if (*p == '\n') {
+      std::string text = partial != NO_PARTIAL ? partial_text : std::string();
+      lexer_error("Invalid token '\"" + text +
+        "': string values require an opening and closing quotation mark,", start_line, start_column);
+    }
+    // backslash: skip it and the character it escapes
+    if (p + 1 == end) {
+      escape = true;
+      return nullptr;
+    }
+    p += 2;
+  }
+}
+
+
+void PushParser::string_token(std::string_view lexeme, int token_line, int token_column)
+{
+  const char* p = lexeme.data();
+  const char* end = p + lexeme.size();
+  while ((p = static_cast<const char*>(std::memchr(p, '\\', end - p)))) {
+    int len = escape_length(p, end);
+    if (!len)
+      lexer_error("Invalid token '\"" + std::string(lexeme.data(), p + (p + 1 != end ? 2 : 1)) +
+        "': invalid escape sequence,", token_line, token_column);
+    p += len;
+  }
+  token(Token(STRING_VAL, lexeme, token_line, token_column));
+}
+
+
+void PushParser::number_token(std::string_view lexeme, int token_line, int token_column)
+{
+  // the same checks as Lexer::next_token(), in the same order
+  const char* begin = lexeme.data();
+  const char* p = begin;
+  const char* end = p + lexeme.size();
+  if (p != end && *p == '-') ++p;
+  if (p == end || !is_digit(*p))
+    lexer_error("Invalid token,", token_line, token_column);
+  if (*p == '0' && p + 1 != end && p[1] == '0')
+    lexer_error("Invalid token: leading 0's are not allowed,", token_line, token_column);
+  while (p != end && is_digit(*p)) ++p;
+  if (p != end && *p == '.') {
+    ++p;
+    if (p == end || !is_digit(*p))
+      lexer_error("Invalid token: '" + std::string(begin, p) +
+        "': double values must have at least one trailing digit,", token_line, token_column);
+    while (p != end && is_digit(*p)) ++p;
+  }
+  if (p != end && (*p == 'e' || *p == 'E')) {
+    ++p;
+    if (p != end && (*p == '-' || *p == '+')) ++p;
+    if (p == end || !is_digit(*p))
+      lexer_error("Invalid token: '" + std::string(begin, p == end ? p : p + 1) + "':", token_line, token_column);
+    while (p != end && is_digit(*p)) ++p;
+  }
+  if (p != end)
+    lexer_error("Invalid token '\"" + std::string(lexeme) + "'", token_line, token_column);
+  token(Token(NUMBER_VAL, lexeme, token_line, token_column));
+}
+
+
+void PushParser::literal_token(std::string_view lexeme, int token_line, int token_column)
+{
+  if (lexeme != "true" && lexeme != "false" && lexeme != "null")
+    lexer_error("Invalid token '\"" + std::string(lexeme) + "'", token_line, token_column);
+  token(Token(LITERAL_VAL, lexeme, token_line, token_column));
+}
+
+
+//----------------------------------------------------------------------
+// Grammar
+//----------------------------------------------------------------------
+
+void PushParser::token(const Token& t)
+{
+  switch (state) {
+    case EXPECT_END:
+      if (!multiple_values)
+        syntax_error("Unexpected token: expected end-of-file, ", t);
+      state = EXPECT_VALUE;
+      // the next top-level value
+      [[fallthrough]];
+    case EXPECT_VALUE:
+    case EXPECT_VALUE_OR_END_ARRAY:
+      if ((t.type() == LBRACE || t.type() == LBRACKET) && max_depth && containers.size() >= max_depth)
+        syntax_error("Maximum nesting depth of " + std::to_string(max_depth) + " exceeded, ", t);
+      switch (t.type()) {
+        case LBRACE:
+          handler.start_object(t);
+          containers.push_back('{');
+          state = EXPECT_KEY_OR_END_OBJECT;
+          return;
+        case LBRACKET:
+          handler.start_array(t);
+          containers.push_back('[');
+          state = EXPECT_VALUE_OR_END_ARRAY;
+          return;
+        case STRING_VAL:
+          handler.string_value(t);
+          after_value();
+          return;
+        case NUMBER_VAL:
+          handler.number_value(t);
+          after_value();
+          return;
+        case LITERAL_VAL:
+          handler.literal_value(t);
+          after_value();
+          return;
+        case RBRACKET:
+          if (state == EXPECT_VALUE_OR_END_ARRAY) {
+            containers.pop_back();
+            handler.end_array(t);
+            after_value();
+            return;
+          }
+          break;
+        default:
+          break;
+      }
+      syntax_error("Unexpected token: expected value, ", t);
+      return;
+    case EXPECT_KEY_OR_END_OBJECT:
+    case EXPECT_KEY:
+      if (t.type() == STRING_VAL) {
+        handler.key(t);
+        state = EXPECT_COLON;
+        return;
+      }
+      if (t.type() == RBRACE && state == EXPECT_KEY_OR_END_OBJECT) {
+        containers.pop_back();
+        handler.end_object(t);
+        after_value();
+        return;
+      }
+      syntax_error("Unexpected token: expected string, ", t);
+      return;
+    case EXPECT_COLON:
+      if (t.type() != COLON)
+        syntax_error("Unexpected token: expected ':', ", t);
+      state = EXPECT_VALUE;
+      return;
+    case EXPECT_COMMA_OR_END:
+      if (t.type() == COMMA) {
+        state = containers.back() == '{' ? EXPECT_KEY : EXPECT_VALUE;
+        return;
+      }
+      if (containers.back() == '{') {
+        if (t.type() != RBRACE)
+          syntax_error("Unexpected token: expected ',', ", t);
+        containers.pop_back();
+        handler.end_object(t);
+      } else {
+        if (t.type() != RBRACKET)
+          syntax_error("Unexpected token: expected ']', ", t);
+        containers.pop_back();
+        handler.end_array(t);
+      }
+      after_value();
+      return;
+  }
+}
+
+
+void PushParser::after_value()
+{
+  if (!containers.empty()) {
+    state = EXPECT_COMMA_OR_END;
+    return;
+  }
+  state = EXPECT_END;
+  handler.end_document();
+}
+
+
+void PushParser::syntax_error(const std::string& msg, const Token& t) const
+{
+  throw JSONException(SYNTAX, msg + "found '" + std::string(t.lexeme()) + "'", t.line(), t.column());
+}
+
+
+void PushParser::lexer_error(const std::string& msg, int error_line, int error_column) const
+{
+  throw JSONException(LEXER, msg, error_line, error_column);
+}
+
+
+#endif // ifndef PUSH_PARSER_CPP
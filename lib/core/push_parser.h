@@ -0,0 +1,112 @@
+#ifndef PUSH_PARSER_H
+#define PUSH_PARSER_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "token.h"
+#include "json_exception.h"
+#include "handler.h"
+#include "parser.h"
+
+
+//----------------------------------------------------------------------
+// Incremental (push) parser
+//----------------------------------------------------------------------
+
+// Parses input handed over in arbitrary chunks, for callers that cannot
+// block on a stream (event loops, sockets). Tokens and UTF-8 sequences may
+// be split anywhere between chunks. The grammar is the same as Parser's,
+// but kept as an explicit state and container stack instead of recursion,
+// so a parse can stop at the end of any chunk and resume with the next.
+// Events go to a Handler as soon as each token is complete; lexemes point
+// into the chunk (or into an internal buffer for tokens that were split)
+// and are only valid during the call. Errors throw JSONException worded
+// like Lexer's and Parser's; the parser must be reset() before it is used
+// again.
+class PushParser
+{
+  public:
+    enum Status {
+      NEED_MORE_INPUT,  // the value is not complete yet
+      DONE              // a complete value has been parsed
+    };
+
+    // with multiple_values, any number of whitespace-separated top-level
+    // values is accepted and each one ends with Handler::end_document().
+    // Containers nested deeper than max_depth (0 for no limit) fail as in
+    // Parser::set_max_depth()
+    explicit PushParser(Handler& handler, bool multiple_values = false,
+                        std::size_t max_depth = Parser::DEFAULT_MAX_DEPTH);
+
+    // consume the next chunk of input
+    Status feed(const char* data, std::size_t size);
+    Status feed(std::string_view data);
+
+    // no more input will follow: completes a number or literal cut off by
+    // the end of input, and throws if the value is incomplete
+    void finish();
+
+    // start over with a new document (same handler)
+    void reset();
+
+    // the number of open containers
+    std::size_t depth() const;
+
+  private:
+    // what the grammar expects next
+    enum State {
+      EXPECT_VALUE,
+      EXPECT_VALUE_OR_END_ARRAY,  // just after '['
+      EXPECT_KEY_OR_END_OBJECT,   // just after '{'
+      EXPECT_KEY,                 // after ',' in an object
+      EXPECT_COLON,
+      EXPECT_COMMA_OR_END,        // after a value inside a container
+      EXPECT_END                  // after the top-level value
+    };
+
+    // a token cut off by the end of a chunk
+    enum Partial { NO_PARTIAL, PARTIAL_STRING, PARTIAL_NUMBER, PARTIAL_LITERAL };
+
+    Handler& handler;
+    bool multiple_values;
+    std::size_t max_depth;
+    State state;
+    // '{' or '[' for every open container
+    std::vector<char> containers;
+
+    Partial partial;
+    std::string partial_text;
+    // the partial string ended on the backslash of an escape
+    bool partial_escape;
+    int partial_line;
+    int partial_column;
+
+    int line;
+    int column;
+
+    // scan one chunk; returns the status after it
+    Status scan(const char* p, const char* end);
+
+    // continue the partial token at p; returns where scanning resumes
+    const char* resume_partial(const char* p, const char* end);
+
+    // the end of the string whose contents start at p (the closing quote),
+    // or nullptr if it runs past end; escape is the pending-escape state
+    const char* string_end(const char* p, const char* end, bool& escape, int start_line, int start_column);
+
+    // validate and report a complete token
+    void string_token(std::string_view lexeme, int line, int column);
+    void number_token(std::string_view lexeme, int line, int column);
+    void literal_token(std::string_view lexeme, int line, int column);
+
+    // advance the grammar by one token
+    void token(const Token& t);
+    void after_value();
+    void syntax_error(const std::string& msg, const Token& t) const;
+    void lexer_error(const std::string& msg, int line, int column) const;
+};
+
+
+#endif // ifndef PUSH_PARSER_H
@@ -0,0 +1,409 @@
+#ifndef STRUCTURAL_INDEX_CPP
+#define STRUCTURAL_INDEX_CPP
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include "structural_index.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define WJSON_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+
+namespace {
+
+// bitmasks for one 64-byte block (bit i is byte i)
+struct BlockMasks
+{
+  std::uint64_t quote;
+  std::uint64_t backslash;
+  std::uint64_t op;         // { } [ ] : ,
+  std::uint64_t whitespace; // everything Lexer::skipNextChar() skips
+  std::uint64_t newline;
+};
+
+// carried from one block to the next
+struct BlockState
+{
+  std::uint64_t prev_escaped = 0;   // last block ended in an odd backslash run
+  std::uint64_t prev_in_string = 0; // all ones if the last block ended inside a string
+  std::uint64_t prev_scalar = 0;    // last byte of the last block was part of a scalar
+  std::size_t error_pos = static_cast<std::size_t>(-1); // first newline inside a string
+};
+
+typedef void (*Classifier)(const char*, BlockMasks&);
+
+const unsigned char CLASS_OP = 1, CLASS_WS = 2, CLASS_QUOTE = 4,
+  CLASS_BACKSLASH = 8, CLASS_NEWLINE = 16;
+
+struct ClassTable
+{
+  unsigned char table[256];
+  ClassTable() {
+    std::memset(table, 0, sizeof(table));
+    for (unsigned char c : std::string("{}[]:,")) table[c] = CLASS_OP;
+    for (unsigned char c : std::string(" \t\r\v\f")) table[c] = CLASS_WS;
+    table[static_cast<unsigned char>('\n')] = CLASS_WS | CLASS_NEWLINE;
+    table[static_cast<unsigned char>('"')] = CLASS_QUOTE;
+    table[static_cast<unsigned char>('\\')] = CLASS_BACKSLASH;
+  }
+};
+const ClassTable char_classes;
+
+
+inline int trailing_zeros(std::uint64_t x)
+{
+#if defined(__GNUC__)
+  return __builtin_ctzll(x);
+#else
+  int n = 0;
+  while (!(x & 1)) { x >>= 1; ++n; }
+  return n;
+#endif
+}
+
+inline int leading_zeros(std::uint64_t x)
+{
+#if defined(__GNUC__)
+  return __builtin_clzll(x);
+#else
+  int n = 0;
+  while (!(x >> 63)) { x <<= 1; ++n; }
+  return n;
+#endif
+}
+
+inline int popcount(std::uint64_t x)
+{
+#if defined(__GNUC__)
+  return __builtin_popcountll(x);
+#else
+  int n = 0;
+  for (; x; x &= x - 1) ++n;
+  return n;
+#endif
+}
+
+// bit i of the result is the xor of bits 0..i of x
+inline std::uint64_t prefix_xor(std::uint64_t x)
+{
+  x ^= x << 1;
+  x ^= x << 2;
+  x ^= x << 4;
+  x ^= x << 8;
+  x ^= x << 16;
+  x ^= x << 32;
+  return x;
+}
+
+
+//----------------------------------------------------------------------
+// Classification kernels
+//----------------------------------------------------------------------
+
+void classify_scalar(const char* block, BlockMasks& m)
+{
+  std::uint64_t quote = 0, backslash = 0, op = 0, ws = 0, nl = 0;
+  for (int i = 0; i < 64; ++i) {
+    unsigned char c = char_classes.table[static_cast<unsigned char>(block[i])];
+    std::uint64_t bit = std::uint64_t(1) << i;
+    if (c & CLASS_QUOTE) quote |= bit;
+    if (c & CLASS_BACKSLASH) backslash |= bit;
+    if (c & CLASS_OP) op |= bit;
+    if (c & CLASS_WS) ws |= bit;
+    if (c & CLASS_NEWLINE) nl |= bit;
+  }
+  m.quote = quote;
+  m.backslash = backslash;
+  m.op = op;
+  m.whitespace = ws;
+  m.newline = nl;
+}
+
+#ifdef WJSON_X86_SIMD
+
+// SSE4.2: character-set matches with PCMPESTRM, 16 bytes at a time
+__attribute__((target("sse4.2")))
+void classify_sse42(const char* block, BlockMasks& m)
+{
+  const __m128i ops = _mm_setr_epi8('{', '}', '[', ']', ':', ',', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m128i spaces = _mm_setr_epi8(' ', '\t', '\n', '\r', '\v', '\f', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i newline = _mm_set1_epi8('\n');
+  const int mode = _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_BIT_MASK;
+  m = BlockMasks();
+  for (int i = 0; i < 4; ++i) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+    int shift = 16 * i;
+    m.op |= std::uint64_t(_mm_cvtsi128_si32(_mm_cmpestrm(ops, 6, v, 16, mode)) & 0xffff) << shift;
+    m.whitespace |= std::uint64_t(_mm_cvtsi128_si32(_mm_cmpestrm(spaces, 6, v, 16, mode)) & 0xffff) << shift;
+    m.quote |= std::uint64_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, quote)) & 0xffff) << shift;
+    m.backslash |= std::uint64_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, backslash)) & 0xffff) << shift;
+    m.newline |= std::uint64_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, newline)) & 0xffff) << shift;
+  }
+}
+
+// AVX2: byte compares, 32 bytes at a time
+__attribute__((target("avx2")))
+inline std::uint64_t avx2_eq(__m256i lo, __m256i hi, char c)
+{
+  const __m256i needle = _mm256_set1_epi8(c);
+  std::uint32_t l = _mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, needle));
+  std::uint32_t h = _mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, needle));
+  return std::uint64_t(l) | (std::uint64_t(h) << 32);
+}
+
+__attribute__((target("avx2")))
+void classify_avx2(const char* block, BlockMasks& m)
+{
+  __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+  __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+  m.quote = avx2_eq(lo, hi, '"');
+  m.backslash = avx2_eq(lo, hi, '\\');
+  m.newline = avx2_eq(lo, hi, '\n');
+  m.op = avx2_eq(lo, hi, '{') | avx2_eq(lo, hi, '}') | avx2_eq(lo, hi, '[')
+    | avx2_eq(lo, hi, ']') | avx2_eq(lo, hi, ':') | avx2_eq(lo, hi, ',');
+  m.whitespace = avx2_eq(lo, hi, ' ') | avx2_eq(lo, hi, '\t') | m.newline
+    | avx2_eq(lo, hi, '\r') | avx2_eq(lo, hi, '\v') | avx2_eq(lo, hi, '\f');
+}
+
+#endif // ifdef WJSON_X86_SIMD
+
+
+//----------------------------------------------------------------------
+// Block processing (shared by every kernel)
+//----------------------------------------------------------------------
+
+// find the unescaped quotes of a block and the string interiors:
+// string_tail is everything after an opening quote up to and including the
+// closing quote
+inline std::uint64_t find_strings(const BlockMasks& m, BlockState& s, std::uint64_t& string_tail)
+{
+  // find escaped characters: a backslash run of odd length escapes the
+  // character after it
+  const std::uint64_t even_bits = 0x5555555555555555ULL;
+  std::uint64_t backslash = m.backslash & ~s.prev_escaped;
+  std::uint64_t follows_escape = (backslash << 1) | s.prev_escaped;
+  std::uint64_t odd_starts = backslash & ~even_bits & ~follows_escape;
+  std::uint64_t even_starts = odd_starts + backslash;
+  s.prev_escaped = even_starts < odd_starts ? 1 : 0;
+  std::uint64_t escaped = (even_bits ^ (even_starts << 1)) & follows_escape;
+
+  // string interiors: the opening quote is in in_string, the closing quote
+  // is not, so string_tail is everything after the opening quote up to and
+  // including the closing quote
+  std::uint64_t quote = m.quote & ~escaped;
+  std::uint64_t in_string = prefix_xor(quote) ^ s.prev_in_string;
+  s.prev_in_string = static_cast<std::uint64_t>(static_cast<std::int64_t>(in_string) >> 63);
+  string_tail = in_string ^ quote;
+  return quote;
+}
+
+// turn one block's masks into index entries at out[n...]
+inline void process_block(const BlockMasks& m, BlockState& s, std::size_t base,
+                          std::size_t* out, std::size_t& n)
+{
+  std::uint64_t string_tail;
+  std::uint64_t quote = find_strings(m, s, string_tail);
+
+  // scalars (numbers, literals) start at the first byte of each run of
+  // non-whitespace, non-structural characters outside of strings
+  std::uint64_t scalar = ~(m.op | m.whitespace | m.quote) & ~string_tail;
+  std::uint64_t scalar_start = scalar & ~((scalar << 1) | s.prev_scalar);
+  s.prev_scalar = scalar >> 63;
+
+  std::uint64_t bad = m.newline & string_tail;
+  if (bad && s.error_pos == static_cast<std::size_t>(-1))
+    s.error_pos = base + trailing_zeros(bad);
+
+  std::uint64_t bits = (m.op & ~string_tail) | quote | scalar_start;
+  while (bits) {
+    out[n++] = base + trailing_zeros(bits);
+    bits &= bits - 1;
+  }
+}
+
+// line and column (both from 1) of input[pos]
+void line_column(std::string_view input, std::size_t pos, int& line, int& column)
+{
+  line = 1;
+  std::size_t line_start = 0;
+  for (std::size_t i = 0; i < pos; ++i) {
+    if (input[i] == '\n') {
+      ++line;
+      line_start = i + 1;
+    }
+  }
+  column = static_cast<int>(pos - line_start) + 1;
+}
+
+// report the string containing input[pos] the way Lexer does
+void string_error(std::string_view input, const std::vector<std::size_t>& positions,
+                  std::size_t n, std::size_t pos)
+{
+  std::size_t open = 0;
+  for (std::size_t i = n; i-- > 0;) {
+    if (positions[i] < pos && input[positions[i]] == '"') {
+      open = positions[i];
+      break;
+    }
+  }
+  int line, column;
+  line_column(input, open, line, column);
+  throw JSONException(LEXER, "Invalid token '\"" +
+    std::string(input.substr(open + 1, pos - open - 1)) +
+    "': string values require an opening and closing quotation mark,", line, column);
+}
+
+// the classifier for impl, or the best supported one
+Classifier classifier(StructuralIndex::Implementation impl)
+{
+  if (impl == StructuralIndex::AUTO || !StructuralIndex::supported(impl))
+    impl = StructuralIndex::best_implementation();
+#ifdef WJSON_X86_SIMD
+  if (impl == StructuralIndex::AVX2) return classify_avx2;
+  if (impl == StructuralIndex::SSE42) return classify_sse42;
+#endif
+  return classify_scalar;
+}
+
+// classify the 64-byte block at base, padding a partial last block with
+// whitespace
+inline void classify_block(Classifier classify, std::string_view input, std::size_t base,
+                           BlockMasks& masks)
+{
+  if (input.size() - base >= 64) {
+    classify(input.data() + base, masks);
+  } else {
+    char tail[64];
+    std::memset(tail, ' ', sizeof(tail));
+    std::memcpy(tail, input.data() + base, input.size() - base);
+    classify(tail, masks);
+  }
+}
+
+} // namespace
+
+
+void StructuralIndex::build(std::string_view input, Implementation impl)
+{
+  Classifier classify = classifier(impl);
+
+  BlockState state;
+  BlockMasks masks;
+  std::size_t n = 0;
+  positions.resize(input.size() / 8 + 64);
+  std::size_t len = input.size();
+  for (std::size_t base = 0; base < len; base += 64) {
+    if (n + 64 > positions.size()) positions.resize(positions.size() * 2);
+    classify_block(classify, input, base, masks);
+    process_block(masks, state, base, positions.data(), n);
+  }
+
+  if (state.error_pos != static_cast<std::size_t>(-1))
+    string_error(input, positions, n, state.error_pos);
+  if (state.prev_in_string)
+    string_error(input, positions, n, len);
+  positions.resize(n);
+}
+
+
+std::vector<StructuralIndex::Split> StructuralIndex::split_array(std::string_view input,
+                                                                std::size_t chunk_size,
+                                                                Implementation impl)
+{
+  Classifier classify = classifier(impl);
+  BlockState state;
+  BlockMasks masks;
+  std::vector<Split> splits;
+  int depth = 0;
+  std::size_t next_cut = chunk_size;
+  // newlines before the current block, and the offset after the last one
+  std::size_t lines = 0;
+  std::size_t line_start = 0;
+
+  for (std::size_t base = 0; base < input.size(); base += 64) {
+    classify_block(classify, input, base, masks);
+    std::uint64_t string_tail;
+    find_strings(masks, state, string_tail);
+    // a string not closed on its line: leave the error to the parser
+    if (masks.newline & string_tail) return std::vector<Split>();
+
+    std::uint64_t ops = masks.op & ~string_tail;
+    while (ops) {
+      int bit = trailing_zeros(ops);
+      ops &= ops - 1;
+      std::size_t pos = base + bit;
+      char c = input[pos];
+      bool split = false;
+      if (c == '[' || c == '{') {
+        // the top level must be an array
+        if (!depth && (c == '{' || !splits.empty())) return std::vector<Split>();
+        split = !depth++;
+      } else if (c == ']' || c == '}') {
+        split = !--depth;
+        if (depth < 0) return std::vector<Split>();
+      } else if (c == ',' && depth == 1 && pos >= next_cut) {
+        split = true;
+        next_cut = pos + chunk_size;
+      }
+      if (!split) continue;
+
+      // line and column from the newlines before pos
+      std::uint64_t before = masks.newline & ((std::uint64_t(1) << bit) - 1);
+      Split s;
+      s.offset = pos;
+      s.line = static_cast<int>(lines + popcount(before)) + 1;
+      std::size_t start = before ? base + 64 - leading_zeros(before) : line_start;
+      s.column = static_cast<int>(pos - start) + 1;
+      splits.push_back(s);
+      if (!depth) return splits;
+    }
+    lines += popcount(masks.newline);
+    if (masks.newline) line_start = base + 64 - leading_zeros(masks.newline);
+  }
+  // the array is never closed
+  return std::vector<Split>();
+}
+
+
+StructuralIndex::Implementation StructuralIndex::best_implementation()
+{
+  if (supported(AVX2)) return AVX2;
+  if (supported(SSE42)) return SSE42;
+  return SCALAR;
+}
+
+
+bool StructuralIndex::supported(Implementation impl)
+{
+  switch (impl) {
+#ifdef WJSON_X86_SIMD
+    case AVX2:
+      return __builtin_cpu_supports("avx2");
+    case SSE42:
+      return __builtin_cpu_supports("sse4.2");
+#endif
+    case SCALAR:
+      return true;
+    default:
+      return false;
+  }
+}
+
+
+const char* StructuralIndex::name(Implementation impl)
+{
+  switch (impl) {
+    case SCALAR: return "scalar";
+    case SSE42: return "sse4.2";
+    case AVX2: return "avx2";
+    default: return "auto";
+  }
+}
+
+
+#endif // ifndef STRUCTURAL_INDEX_CPP
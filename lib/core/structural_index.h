@@ -0,0 +1,61 @@
+#ifndef STRUCTURAL_INDEX_H
+#define STRUCTURAL_INDEX_H
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+#include "json_exception.h"
+
+
+//----------------------------------------------------------------------
+// Stage-one structural index
+//----------------------------------------------------------------------
+
+// Classifies the input 64 bytes at a time into bitmasks (structural
+// characters, quotes, backslash runs, whitespace) and records, in order,
+// the offset of every token start outside of strings plus every unescaped
+// quote (so each string contributes its opening and closing quote).
+//
+// The SIMD kernels are chosen at runtime from what the CPU supports; the
+// scalar kernel produces the same index on any target.
+class StructuralIndex
+{
+  public:
+    enum Implementation { AUTO, SCALAR, SSE42, AVX2 };
+
+    // offsets of the indexed characters, ascending
+    std::vector<std::size_t> positions;
+
+    // index input (throws a LEXER JSONException for a string that is not
+    // closed on the same line)
+    void build(std::string_view input, Implementation impl = AUTO);
+
+    // where a top-level array can be cut between elements: the offset of a
+    // '[', ',' or ']' and its line and column (from 1)
+    struct Split
+    {
+      std::size_t offset;
+      int line;
+      int column;
+    };
+
+    // cut the top-level array of input about every chunk_size bytes with
+    // the same kernels, without keeping an index: the opening bracket,
+    // commas at depth 1, then the closing bracket. Returns nothing if the
+    // first value of input is not an array or is not closed, or a string
+    // is not closed on its line (the parser reports those errors)
+    static std::vector<Split> split_array(std::string_view input, std::size_t chunk_size,
+                                          Implementation impl = AUTO);
+
+    // the fastest kernel supported by this CPU
+    static Implementation best_implementation();
+
+    // whether this CPU (and build) can run a kernel
+    static bool supported(Implementation impl);
+
+    // kernel name for printing
+    static const char* name(Implementation impl);
+};
+
+
+#endif // ifndef STRUCTURAL_INDEX_H
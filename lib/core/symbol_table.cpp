@@ -0,0 +1,100 @@
+#ifndef SYMBOL_TABLE_CPP
+#define SYMBOL_TABLE_CPP
+
+#include "symbol_table.h"
+#include "json_string.h"
+
+
+namespace {
+
+const std::size_t INITIAL_SLOTS = 256;
+const std::size_t HEADER = 2 * sizeof(std::uint32_t);
+
+std::uint32_t stored_size(const char* text)
+{
+  std::uint32_t size;
+  std::memcpy(&size, text - sizeof(std::uint32_t), sizeof(size));
+  return size;
+}
+
+} // namespace
+
+
+SymbolTable::SymbolTable()
+  : slots(INITIAL_SLOTS, nullptr), count(0)
+{
+}
+
+
+// the slot holding lexeme, or the empty slot where it belongs
+std::size_t SymbolTable::probe(std::string_view lexeme, std::uint32_t h) const
+{
+  std::size_t mask = slots.size() - 1;
+  std::size_t slot = h & mask;
+  for (const char* text; (text = slots[slot]); slot = (slot + 1) & mask) {
+    std::string_view symbol(text, stored_size(text));
+    if (hash(symbol) == h && symbol == lexeme)
+      break;
+  }
+  return slot;
+}
+
+
+std::string_view SymbolTable::intern(std::string_view lexeme)
+{
+  std::uint32_t h = hash_bytes(lexeme);
+  std::size_t slot = probe(lexeme, h);
+  if (!slots[slot]) {
+    // keep the load at most one half
+    if (2 * (count + 1) > slots.size()) {
+      grow();
+      slot = probe(lexeme, h);
+    }
+    std::uint32_t size = static_cast<std::uint32_t>(lexeme.size());
+    char* record = static_cast<char*>(storage.allocate(HEADER + size, alignof(std::uint32_t)));
+    std::memcpy(record, &h, sizeof(h));
+    std::memcpy(record + sizeof(h), &size, sizeof(size));
+    std::memcpy(record + HEADER, lexeme.data(), size);
+    slots[slot] = record + HEADER;
+    ++count;
+  }
+  return std::string_view(slots[slot], lexeme.size());
+}
+
+
+std::string_view SymbolTable::find(std::string_view lexeme) const
+{
+  const char* text = slots[probe(lexeme, hash_bytes(lexeme))];
+  return text ? std::string_view(text, lexeme.size()) : std::string_view();
+}
+
+
+std::size_t SymbolTable::size() const
+{
+  return count;
+}
+
+
+void SymbolTable::clear()
+{
+  storage.release();
+  slots.assign(INITIAL_SLOTS, nullptr);
+  count = 0;
+}
+
+
+void SymbolTable::grow()
+{
+  std::vector<const char*> old(slots.size() * 2, nullptr);
+  old.swap(slots);
+  std::size_t mask = slots.size() - 1;
+  for (const char* text : old) {
+    if (!text) continue;
+    std::size_t slot = hash(std::string_view(text, 0)) & mask;
+    while (slots[slot]) slot = (slot + 1) & mask;
+    slots[slot] = text;
+  }
+}
+
+
+#endif // ifndef SYMBOL_TABLE_CPP
@@ -0,0 +1,67 @@
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+#include "arena.h"
+
+
+//----------------------------------------------------------------------
+// Interned object keys
+//----------------------------------------------------------------------
+
+// Stores each distinct key lexeme (raw, escapes not decoded) once, with
+// its hash kept in front of the text. A parser given a table
+// (Parser::set_symbol_table()) points every key token of the documents it
+// builds at the stored copy, so within one table equal keys share one
+// pointer and can be compared by lexeme().data(); JSON::find_symbol()
+// looks members up that way, with the stored hash. The table may be
+// shared by any number of parses, one at a time, and must outlive the
+// documents built with it.
+class SymbolTable
+{
+  public:
+    SymbolTable();
+
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable& operator=(const SymbolTable&) = delete;
+
+    // the stored copy of lexeme, added on first use
+    std::string_view intern(std::string_view lexeme);
+
+    // the stored copy of lexeme, or a null view if it was never interned
+    std::string_view find(std::string_view lexeme) const;
+
+    // the hash of a view returned by intern() or find(), read from the
+    // table rather than recomputed
+    static std::uint32_t hash(std::string_view symbol);
+
+    // number of distinct keys
+    std::size_t size() const;
+
+    // forget every key (invalidates every stored copy)
+    void clear();
+
+  private:
+    // [hash][size][text] records; slots hold text pointers (or nullptr)
+    Arena storage;
+    std::vector<const char*> slots;
+    std::size_t count;
+
+    std::size_t probe(std::string_view lexeme, std::uint32_t h) const;
+    void grow();
+};
+
+
+inline std::uint32_t SymbolTable::hash(std::string_view symbol)
+{
+  std::uint32_t h;
+  std::memcpy(&h, symbol.data() - 2 * sizeof(std::uint32_t), sizeof(h));
+  return h;
+}
+
+
+#endif // ifndef SYMBOL_TABLE_H
@@ -0,0 +1,268 @@
+#ifndef TAPE_CPP
+#define TAPE_CPP
+
+#include <new>
+#include "tape.h"
+#include "json_string.h"
+
+static const int TAG_SHIFT = 56;
+static const std::uint64_t PAYLOAD_MASK = (std::uint64_t(1) << TAG_SHIFT) - 1;
+
+
+TapeTag Tape::tag(std::size_t i) const
+{
+  return static_cast<TapeTag>(entries[i] >> TAG_SHIFT);
+}
+
+
+std::uint64_t Tape::payload(std::size_t i) const
+{
+  return entries[i] & PAYLOAD_MASK;
+}
+
+
+std::size_t Tape::next(std::size_t i) const
+{
+  switch (tag(i)) {
+    case TAPE_START_OBJECT:
+    case TAPE_START_ARRAY:
+      return payload(i) + 1;
+    case TAPE_STRING:
+    case TAPE_NUMBER:
+      return i + 2;
+    default:
+      return i + 1;
+  }
+}
+
+
+std::string_view Tape::lexeme(std::size_t i) const
+{
+  switch (tag(i)) {
+    case TAPE_STRING:
+    case TAPE_NUMBER:
+      return std::string_view(source_base + payload(i), entries[i + 1]);
+    case TAPE_TRUE:
+      return "true";
+    case TAPE_FALSE:
+      return "false";
+    case TAPE_NULL:
+      return "null";
+    default:
+      return std::string_view();
+  }
+}
+
+
+std::size_t Tape::find_field(std::size_t i, std::string_view key) const
+{
+  if (tag(i) != TAPE_START_OBJECT) return npos;
+  std::size_t close = payload(i);
+  // members alternate key, value
+  for (std::size_t j = i + 1; j < close; j = next(next(j))) {
+    if (json_string_equals(lexeme(j), key)) return next(j);
+  }
+  return npos;
+}
+
+
+void Tape::append(TapeTag t, std::uint64_t payload)
+{
+  entries.push_back((std::uint64_t(t) << TAG_SHIFT) | payload);
+}
+
+
+void Tape::append_lexeme(TapeTag t, std::string_view lexeme)
+{
+  append(t, lexeme.data() - source_base);
+  entries.push_back(lexeme.size());
+}
+
+
+//----------------------------------------------------------------------
+// Tape builder
+//----------------------------------------------------------------------
+
+TapeBuilder::TapeBuilder(Tape& t, bool copy_lexemes)
+  : tape(t)
+{
+  if (copy_lexemes) {
+    copies = std::make_shared<std::string>();
+    tape.source = copies;
+    tape.source_base = nullptr;
+  }
+}
+
+
+void TapeBuilder::scalar(TapeTag t, std::string_view lexeme)
+{
+  if (!copies) {
+    tape.append_lexeme(t, lexeme);
+    return;
+  }
+  // offsets into the copy buffer; source_base is set once it stops moving
+  tape.append(t, copies->size());
+  tape.entries.push_back(lexeme.size());
+  copies->append(lexeme.data(), lexeme.size());
+}
+
+
+void TapeBuilder::close(TapeTag t)
+{
+  // link the open and close entries to each other
+  std::size_t start = open.back();
+  open.pop_back();
+  tape.entries[start] |= tape.entries.size();
+  tape.append(t, start);
+}
+
+
+void TapeBuilder::start_object(const Token&)
+{
+  open.push_back(tape.entries.size());
+  tape.append(TAPE_START_OBJECT, 0);
+}
+
+
+void TapeBuilder::key(const Token& t)
+{
+  scalar(TAPE_STRING, t.lexeme());
+}
+
+
+void TapeBuilder::end_object(const Token&)
+{
+  close(TAPE_END_OBJECT);
+}
+
+
+void TapeBuilder::start_array(const Token&)
+{
+  open.push_back(tape.entries.size());
+  tape.append(TAPE_START_ARRAY, 0);
+}
+
+
+void TapeBuilder::end_array(const Token&)
+{
+  close(TAPE_END_ARRAY);
+}
+
+
+void TapeBuilder::string_value(const Token& t)
+{
+  scalar(TAPE_STRING, t.lexeme());
+}
+
+
+void TapeBuilder::number_value(const Token& t)
+{
+  scalar(TAPE_NUMBER, t.lexeme());
+}
+
+
+void TapeBuilder::literal_value(const Token& t)
+{
+  switch (t.lexeme()[0]) {
+    case 't': tape.append(TAPE_TRUE, 0); break;
+    case 'f': tape.append(TAPE_FALSE, 0); break;
+    default: tape.append(TAPE_NULL, 0); break;
+  }
+}
+
+
+void TapeBuilder::end_document()
+{
+  if (copies) tape.source_base = copies->data();
+}
+
+
+//----------------------------------------------------------------------
+// Visitor adapter
+//----------------------------------------------------------------------
+
+void Tape::to_document(JSONDocument& doc) const
+{
+  doc.source = source;
+  std::size_t i = 0;
+  doc.root = entries.empty() ? nullptr : build(i, doc.arena);
+}
+
+
+void Tape::accept(Visitor& v) const
+{
+  JSONDocument doc;
+  to_document(doc);
+  doc.accept(v);
+}
+
+
+// build the value starting at i and advance i past it
+RValue* Tape::build(std::size_t& i, Arena& arena) const
+{
+  switch (tag(i)) {
+    case TAPE_START_OBJECT:
+    {
+      JSON* node = arena.create<JSON>();
+      std::size_t close = payload(i);
+      std::size_t n = 0;
+      for (std::size_t j = i + 1; j < close; j = next(next(j))) ++n;
+      Record* records = n
+        ? static_cast<Record*>(arena.allocate(sizeof(Record) * n, alignof(Record)))
+        : nullptr;
+      ++i;
+      for (std::size_t k = 0; k < n; ++k) {
+        Record* r = new (records + k) Record;
+        r->key = Token(STRING_VAL, lexeme(i), 0, 0);
+        i = next(i);
+        r->value = build(i, arena);
+      }
+      node->records.items = records;
+      node->records.count = n;
+      node->build_index(arena);
+      node->rbrace_token = Token(RBRACE, "}", 0, 0);
+      i = close + 1;
+      return node;
+    }
+    case TAPE_START_ARRAY:
+    {
+      Array* node = arena.create<Array>();
+      std::size_t close = payload(i);
+      std::size_t n = 0;
+      for (std::size_t j = i + 1; j < close; j = next(j)) ++n;
+      RValue** values = n
+        ? static_cast<RValue**>(arena.allocate(sizeof(RValue*) * n, alignof(RValue*)))
+        : nullptr;
+      ++i;
+      for (std::size_t k = 0; k < n; ++k) values[k] = build(i, arena);
+      node->values.items = values;
+      node->values.count = n;
+      node->rbracket_token = Token(RBRACKET, "]", 0, 0);
+      i = close + 1;
+      return node;
+    }
+    default:
+    {
+      SimpleRValue* node = arena.create<SimpleRValue>();
+      switch (tag(i)) {
+        case TAPE_STRING:
+          node->type = STRING_TYPE;
+          node->value = Token(STRING_VAL, lexeme(i), 0, 0);
+          break;
+        case TAPE_NUMBER:
+          node->type = NUMBER_TYPE;
+          node->value = Token(NUMBER_VAL, lexeme(i), 0, 0);
+          break;
+        default:
+          node->type = LITERAL_TYPE;
+          node->value = Token(LITERAL_VAL, lexeme(i), 0, 0);
+          break;
+      }
+      i = next(i);
+      return node;
+    }
+  }
+}
+
+
+#endif // ifndef TAPE_CPP
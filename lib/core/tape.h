@@ -0,0 +1,110 @@
+#ifndef TAPE_H
+#define TAPE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "ast.h"
+#include "handler.h"
+
+
+//----------------------------------------------------------------------
+// Flat (tape) document representation
+//----------------------------------------------------------------------
+
+// Each entry is 64 bits: an 8-bit tag in the top byte and a 56-bit
+// payload. Values are laid out in document order:
+//   - '{' / '[' : payload is the index of the matching '}' / ']' entry
+//   - '}' / ']' : payload is the index of the matching '{' / '[' entry
+//   - '"' / 'd' : payload is the offset of the lexeme in the source; the
+//                 next entry holds the lexeme length (strings and numbers
+//                 take two entries, object keys are strings)
+//   - 't' / 'f' / 'n' : literals, no payload
+enum TapeTag : unsigned char {
+  TAPE_START_OBJECT = '{', TAPE_END_OBJECT = '}',
+  TAPE_START_ARRAY = '[', TAPE_END_ARRAY = ']',
+  TAPE_STRING = '"', TAPE_NUMBER = 'd',
+  TAPE_TRUE = 't', TAPE_FALSE = 'f', TAPE_NULL = 'n'
+};
+
+
+class Tape
+{
+  public:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    // the entries (the root value starts at index 0)
+    std::vector<std::uint64_t> entries;
+
+    // start of the source buffer lexeme offsets are relative to
+    const char* source_base = nullptr;
+
+    // keeps the input buffer alive when it is owned by the lexer
+    std::shared_ptr<const void> source;
+
+    // tag and payload of the entry at index i
+    TapeTag tag(std::size_t i) const;
+    std::uint64_t payload(std::size_t i) const;
+
+    // index of the entry just past the value starting at i (containers
+    // are skipped in O(1) using the matching close index)
+    std::size_t next(std::size_t i) const;
+
+    // lexeme of the scalar value starting at i (quotes are not included)
+    std::string_view lexeme(std::size_t i) const;
+
+    // index of the value for the first member named key (compared with
+    // escape sequences decoded, as JSON::find() does) in the object
+    // starting at i, or npos
+    std::size_t find_field(std::size_t i, std::string_view key) const;
+
+    // append entries (used while parsing)
+    void append(TapeTag, std::uint64_t payload);
+    void append_lexeme(TapeTag, std::string_view lexeme);
+
+    // build the equivalent AST in doc (tokens carry no line or column)
+    void to_document(JSONDocument& doc) const;
+
+    // adapter for existing visitors: materializes the tree and visits it
+    void accept(Visitor&) const;
+
+  private:
+    RValue* build(std::size_t& i, Arena& arena) const;
+};
+
+
+// Handler that records the events onto a tape
+class TapeBuilder final : public Handler
+{
+  public:
+    // append to tape, whose lexeme offsets are relative to source_base.
+    // With copy_lexemes the lexemes are instead copied into a buffer owned
+    // by the tape (see Lexer::stable_tokens())
+    TapeBuilder(Tape& tape, bool copy_lexemes);
+
+    void start_object(const Token&) override;
+    void key(const Token&) override;
+    void end_object(const Token&) override;
+    void start_array(const Token&) override;
+    void end_array(const Token&) override;
+    void string_value(const Token&) override;
+    void number_value(const Token&) override;
+    void literal_value(const Token&) override;
+    void end_document() override;
+
+  private:
+    Tape& tape;
+    // indexes of the open containers' start entries
+    std::vector<std::size_t> open;
+    // lexeme copies when the tokens are not stable
+    std::shared_ptr<std::string> copies;
+
+    void scalar(TapeTag, std::string_view lexeme);
+    void close(TapeTag);
+};
+
+
+#endif // ifndef TAPE_H
@@ -4,11 +4,12 @@
 #define TOKEN_H
 
 #include <string>
-#include <map>
+#include <string_view>
+#include <type_traits>
 
 
 // JSON allowable token types
-enum TokenType {
+enum TokenType : unsigned char {
 	// basic symbols
 	COMMA, COLON, LBRACKET, RBRACKET, LBRACE, RBRACE,
 	// values
@@ -25,14 +26,16 @@ public:
 	// default constructor
 	Token();
 
-	// constructor
-	Token(TokenType type, const std::string& lexeme, int line, int column);
+	// constructor (the lexeme is not copied: it must point into storage
+	// that outlives the token, normally the lexer's input buffer)
+	Token(TokenType type, std::string_view lexeme, int line, int column);
 
 	// return the type of the token
 	TokenType type() const;
 
-	// return the token string value
-	std::string lexeme() const;
+	// return the token string value (a view into the source buffer; copy it
+	// into a std::string to keep it past the lifetime of the source)
+	std::string_view lexeme() const;
 
 	// return the line location of lexeme
 	int line() const;
@@ -45,11 +48,10 @@ public:
 
 private:
 
-	// the type of the token
-	TokenType token_type;
-
-	// the token's value in the program
-	std::string token_lexeme;
+	// the token's value in the program (start and length of the lexeme
+	// in the source buffer)
+	const char* token_lexeme;
+	unsigned int token_lexeme_length;
 
 	// the line location of the lexeme (starts at 1)
 	int token_line;
@@ -57,18 +59,66 @@ private:
 	// the column location of the start of the lexeme (starts at 1)
 	int token_column;
 
-	// token type to string representation (for printing)
-	std::map<TokenType, std::string> token_type_map =
-    { // basic symbols
-        {COMMA, "COMMA"}, {COLON, "COLON"}, {LBRACKET, "LBRACKET"},
-		{RBRACKET, "RBRACKET"}, {LBRACE, "LBRACE"}, {RBRACE, "RBRACE"},
+	// the type of the token
+	TokenType token_type;
+
+	// token type to string representation (for printing), indexed by TokenType
+	static constexpr const char* token_type_names[] =
+	{ // basic symbols
+		"COMMA", "COLON", "LBRACKET", "RBRACKET", "LBRACE", "RBRACE",
 		// values
-		{LITERAL_VAL, "LITERAL_VAL"}, {NUMBER_VAL, "NUMBER_VAL"},
-		{STRING_VAL, "STRING_VAL"},
+		"LITERAL_VAL", "NUMBER_VAL", "STRING_VAL",
 		// eos
-		{EOS, "EOS"}
+		"EOS"
 	};
 };
 
+// tokens are copied around freely by the lexer and parser, so keep them
+// plain data (24 bytes on 64-bit targets)
+static_assert(std::is_trivially_copyable<Token>::value, "Token must be trivially copyable");
+static_assert(sizeof(Token) <= 24, "Token should stay compact");
+
+
+// the lexer and parser touch these for every token, and they are
+// compiled separately from token.cpp, so keep them inline
+
+// default constructor
+inline Token::Token()
+	: token_lexeme(nullptr), token_lexeme_length(0), token_line(0),
+	  token_column(0), token_type(EOS)
+{
+}
+
+// constructor
+inline Token::Token(TokenType type, std::string_view lexeme, int line, int column)
+	: token_lexeme(lexeme.data()), token_lexeme_length(lexeme.size()),
+	  token_line(line), token_column(column), token_type(type)
+{
+}
+
+// return the type of the token
+inline TokenType Token::type() const
+{
+	return token_type;
+}
+
+// return the token string value
+inline std::string_view Token::lexeme() const
+{
+	return std::string_view(token_lexeme, token_lexeme_length);
+}
+
+// return the line location of lexeme
+inline int Token::line() const
+{
+	return token_line;
+}
+
+// return the column location where the lexeme starts
+inline int Token::column() const
+{
+	return token_column;
+}
+
 
 #endif // ifndef TOKEN_H
@@ -0,0 +1,253 @@
+#ifndef BINARY_WRITERS_CPP
+#define BINARY_WRITERS_CPP
+
+#include <cstring>
+
+// libwjson core modules
+#include <core/json_string.h>
+#include <printer/binary_writers.h>
+
+
+// n big-endian bytes of v
+static void big_endian(OutputBuffer& out, std::uint64_t v, int n)
+{
+	unsigned char bytes[8];
+	for(int i = n - 1; i >= 0; --i, v >>= 8)
+		bytes[i] = static_cast<unsigned char>(v);
+	out.write(reinterpret_cast<const char*>(bytes), n);
+}
+
+static std::uint64_t double_bits(const SimpleRValue& node)
+{
+	double d;
+	node.get_double(d);
+	std::uint64_t bits;
+	std::memcpy(&bits, &d, sizeof(bits));
+	return bits;
+}
+
+
+//----------------------------------------------------------------------
+// CBORWriter
+//----------------------------------------------------------------------
+
+CBORWriter::CBORWriter(std::ostream& output_stream)
+: out(output_stream) {}
+
+void CBORWriter::flush()
+{
+	out.flush();
+}
+
+void CBORWriter::head(unsigned int major, std::uint64_t arg)
+{
+	unsigned char type = static_cast<unsigned char>(major << 5);
+	if(arg < 24) {
+		out.put(static_cast<char>(type | arg));
+	} else if(arg <= 0xff) {
+		out.put(static_cast<char>(type | 24));
+		big_endian(out, arg, 1);
+	} else if(arg <= 0xffff) {
+		out.put(static_cast<char>(type | 25));
+		big_endian(out, arg, 2);
+	} else if(arg <= 0xffffffff) {
+		out.put(static_cast<char>(type | 26));
+		big_endian(out, arg, 4);
+	} else {
+		out.put(static_cast<char>(type | 27));
+		big_endian(out, arg, 8);
+	}
+}
+
+void CBORWriter::string(std::string_view lexeme)
+{
+	text.clear();
+	unescape_json_string(lexeme, text);
+	head(3, text.size());
+	out.write(text);
+}
+
+void CBORWriter::visit(JSONDocument& node)
+{
+	node.root->accept(*this);
+	out.flush();
+}
+
+void CBORWriter::visit(JSON& node)
+{
+	head(5, node.records.size());
+	for(Record& r : node.records)
+		r.accept(*this);
+}
+
+void CBORWriter::visit(Record& node)
+{
+	string(node.key.lexeme());
+	node.value->accept(*this);
+}
+
+void CBORWriter::visit(SimpleRValue& node)
+{
+	std::int64_t i;
+	std::uint64_t u;
+	switch(node.type)
+	{
+		case STRING_TYPE:
+			string(node.value.lexeme());
+			break;
+		case NUMBER_TYPE:
+			if(node.get_int64(i) == NUMBER_EXACT) {
+				if(i >= 0)
+					head(0, static_cast<std::uint64_t>(i));
+				else
+					head(1, static_cast<std::uint64_t>(-(i + 1)));
+			} else if(node.get_uint64(u) == NUMBER_EXACT) {
+				head(0, u);
+			} else {
+				out.put(static_cast<char>(0xfb));
+				big_endian(out, double_bits(node), 8);
+			}
+			break;
+		case LITERAL_TYPE:
+			switch(node.value.lexeme()[0])
+			{
+				case 'f': out.put(static_cast<char>(0xf4)); break;
+				case 't': out.put(static_cast<char>(0xf5)); break;
+				default: out.put(static_cast<char>(0xf6)); break;
+			}
+			break;
+		default:
+			break; // no other types
+	}
+}
+
+void CBORWriter::visit(Array& node)
+{
+	head(4, node.values.size());
+	for(RValue* value : node.values)
+		value->accept(*this);
+}
+
+
+//----------------------------------------------------------------------
+// MessagePackWriter
+//----------------------------------------------------------------------
+
+MessagePackWriter::MessagePackWriter(std::ostream& output_stream)
+: out(output_stream) {}
+
+void MessagePackWriter::flush()
+{
+	out.flush();
+}
+
+void MessagePackWriter::sized(unsigned char type, std::uint64_t v, int n)
+{
+	out.put(static_cast<char>(type));
+	big_endian(out, v, n);
+}
+
+void MessagePackWriter::string(std::string_view lexeme)
+{
+	text.clear();
+	unescape_json_string(lexeme, text);
+	std::size_t n = text.size();
+	if(n <= 31)
+		out.put(static_cast<char>(0xa0 | n));
+	else if(n <= 0xff)
+		sized(0xd9, n, 1);
+	else if(n <= 0xffff)
+		sized(0xda, n, 2);
+	else
+		sized(0xdb, n, 4);
+	out.write(text);
+}
+
+// fixmap/fixarray, or the 16- or 32-bit form (type16 + 1)
+void MessagePackWriter::count(unsigned char fix, unsigned char type16, std::size_t n)
+{
+	if(n <= 15)
+		out.put(static_cast<char>(fix | n));
+	else if(n <= 0xffff)
+		sized(type16, n, 2);
+	else
+		sized(type16 + 1, n, 4);
+}
+
+void MessagePackWriter::visit(JSONDocument& node)
+{
+	node.root->accept(*this);
+	out.flush();
+}
+
+void MessagePackWriter::visit(JSON& node)
+{
+	count(0x80, 0xde, node.records.size());
+	for(Record& r : node.records)
+		r.accept(*this);
+}
+
+void MessagePackWriter::visit(Record& node)
+{
+	string(node.key.lexeme());
+	node.value->accept(*this);
+}
+
+void MessagePackWriter::visit(SimpleRValue& node)
+{
+	std::int64_t i;
+	std::uint64_t u;
+	switch(node.type)
+	{
+		case STRING_TYPE:
+			string(node.value.lexeme());
+			break;
+		case NUMBER_TYPE:
+			if(node.get_int64(i) == NUMBER_EXACT && i < 0) {
+				if(i >= -32)
+					out.put(static_cast<char>(i));
+				else if(i >= INT8_MIN)
+					sized(0xd0, static_cast<std::uint64_t>(i), 1);
+				else if(i >= INT16_MIN)
+					sized(0xd1, static_cast<std::uint64_t>(i), 2);
+				else if(i >= INT32_MIN)
+					sized(0xd2, static_cast<std::uint64_t>(i), 4);
+				else
+					sized(0xd3, static_cast<std::uint64_t>(i), 8);
+			} else if(node.get_uint64(u) == NUMBER_EXACT) {
+				if(u <= 0x7f)
+					out.put(static_cast<char>(u));
+				else if(u <= 0xff)
+					sized(0xcc, u, 1);
+				else if(u <= 0xffff)
+					sized(0xcd, u, 2);
+				else if(u <= 0xffffffff)
+					sized(0xce, u, 4);
+				else
+					sized(0xcf, u, 8);
+			} else {
+				sized(0xcb, double_bits(node), 8);
+			}
+			break;
+		case LITERAL_TYPE:
+			switch(node.value.lexeme()[0])
+			{
+				case 'f': out.put(static_cast<char>(0xc2)); break;
+				case 't': out.put(static_cast<char>(0xc3)); break;
+				default: out.put(static_cast<char>(0xc0)); break;
+			}
+			break;
+		default:
+			break; // no other types
+	}
+}
+
+void MessagePackWriter::visit(Array& node)
+{
+	count(0x90, 0xdc, node.values.size());
+	for(RValue* value : node.values)
+		value->accept(*this);
+}
+
+
+#endif // ifndef BINARY_WRITERS_CPP
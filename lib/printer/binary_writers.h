@@ -0,0 +1,75 @@
+#ifndef BINARY_WRITERS_H
+#define BINARY_WRITERS_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// libwjson core modules
+#include <core/ast.h>
+#include <printer/output_buffer.h>
+
+
+//----------------------------------------------------------------------
+// CBOR and MessagePack output
+//----------------------------------------------------------------------
+
+// Serializers for the binary formats read by CBORReader and
+// MessagePackReader, used like Printer (doc.accept(writer)). Strings and
+// keys are written decoded, as UTF-8 text; numbers as the smallest
+// integer encoding when they are exact integers in the 64-bit range, else
+// as a double; objects keep their member order (and duplicate keys).
+// Output goes through an OutputBuffer and reaches the stream when a
+// document has been written, on flush(), or when the writer is destroyed.
+
+// RFC 8949 CBOR with definite lengths
+class CBORWriter : public Visitor
+{
+public:
+	CBORWriter(std::ostream&);
+
+	void visit(JSONDocument&);
+	void visit(JSON&);
+	void visit(Record&);
+	void visit(SimpleRValue&);
+	void visit(Array&);
+
+	void flush();
+
+private:
+	OutputBuffer out;
+	// decoded strings, reused
+	std::string text;
+
+	// a major type with its argument in the shortest form
+	void head(unsigned int major, std::uint64_t arg);
+	void string(std::string_view lexeme);
+};
+
+
+// MessagePack
+class MessagePackWriter : public Visitor
+{
+public:
+	MessagePackWriter(std::ostream&);
+
+	void visit(JSONDocument&);
+	void visit(JSON&);
+	void visit(Record&);
+	void visit(SimpleRValue&);
+	void visit(Array&);
+
+	void flush();
+
+private:
+	OutputBuffer out;
+	std::string text;
+
+	// a type byte followed by n big-endian bytes of v
+	void sized(unsigned char type, std::uint64_t v, int n);
+	void string(std::string_view lexeme);
+	void count(unsigned char fix, unsigned char type16, std::size_t n);
+};
+
+
+#endif // ifndef BINARY_WRITERS_H
@@ -0,0 +1,37 @@
+#ifndef MINIFIER_CPP
+#define MINIFIER_CPP
+
+// libwjson core modules
+#include <core/lexer.h>
+#include <core/parser.h>
+#include <printer/minifier.h>
+
+
+// constructor
+Minifier::Minifier(std::ostream& output_stream)
+: out(output_stream) {}
+
+
+void Minifier::minify(std::string_view input)
+{
+	need_comma = false;
+	Lexer lexer(input);
+	Parser parser(lexer);
+	parser.parse(*this);
+}
+
+void Minifier::minify(std::istream& input, std::size_t chunk_size)
+{
+	need_comma = false;
+	Lexer lexer(input, chunk_size);
+	Parser parser(lexer);
+	parser.parse(*this);
+}
+
+void Minifier::end_document()
+{
+	out.flush();
+}
+
+
+#endif // ifndef MINIFIER_CPP
@@ -0,0 +1,122 @@
+#ifndef MINIFIER_H
+#define MINIFIER_H
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <string_view>
+
+// libwjson core modules
+#include <core/token.h>
+#include <core/handler.h>
+#include <printer/output_buffer.h>
+
+
+//----------------------------------------------------------------------
+// Streaming minifier
+//----------------------------------------------------------------------
+
+// Compacts a document straight from the parser's events, without building
+// a tree: each token's lexeme is copied to the output with the whitespace
+// between tokens dropped, giving exactly Printer's compact output. The
+// input is fully validated as it is read, so on a JSONException the
+// output written so far is cut short; memory does not grow with the
+// document.
+class Minifier final : public Handler
+{
+public:
+	// streams are read this many bytes at a time
+	static constexpr std::size_t DEFAULT_CHUNK_SIZE = 1 << 20;
+
+	Minifier(std::ostream&);
+
+	// minify one document from a buffer, or from a stream read in chunks
+	void minify(std::string_view input);
+	void minify(std::istream& input, std::size_t chunk_size = DEFAULT_CHUNK_SIZE);
+
+	// events (Parser::parse(Handler&) calls these)
+	void start_object(const Token&) override;
+	void key(const Token&) override;
+	void end_object(const Token&) override;
+	void start_array(const Token&) override;
+	void end_array(const Token&) override;
+	void string_value(const Token&) override;
+	void number_value(const Token&) override;
+	void literal_value(const Token&) override;
+	void end_document() override;
+
+private:
+	OutputBuffer out;
+	// whether the next value or key follows a sibling
+	bool need_comma = false;
+
+	void separate();
+};
+
+
+// one call per token, so keep the writers inline
+inline void Minifier::separate()
+{
+	if(need_comma) out.put(',');
+}
+
+inline void Minifier::start_object(const Token&)
+{
+	separate();
+	out.put('{');
+	need_comma = false;
+}
+
+inline void Minifier::key(const Token& t)
+{
+	separate();
+	out.put('"');
+	out.write(t.lexeme());
+	out.write("\":", 2);
+	need_comma = false;
+}
+
+inline void Minifier::end_object(const Token&)
+{
+	out.put('}');
+	need_comma = true;
+}
+
+inline void Minifier::start_array(const Token&)
+{
+	separate();
+	out.put('[');
+	need_comma = false;
+}
+
+inline void Minifier::end_array(const Token&)
+{
+	out.put(']');
+	need_comma = true;
+}
+
+inline void Minifier::string_value(const Token& t)
+{
+	separate();
+	out.put('"');
+	out.write(t.lexeme());
+	out.put('"');
+	need_comma = true;
+}
+
+inline void Minifier::number_value(const Token& t)
+{
+	separate();
+	out.write(t.lexeme());
+	need_comma = true;
+}
+
+inline void Minifier::literal_value(const Token& t)
+{
+	separate();
+	out.write(t.lexeme());
+	need_comma = true;
+}
+
+
+#endif // ifndef MINIFIER_H
@@ -0,0 +1,50 @@
+#ifndef OUTPUT_BUFFER_CPP
+#define OUTPUT_BUFFER_CPP
+
+#include <cstdlib>
+#include <new>
+#include "output_buffer.h"
+
+
+OutputBuffer::OutputBuffer(std::ostream& output_stream, std::size_t flush_threshold)
+: sink(output_stream), threshold(flush_threshold ? flush_threshold : 1), data(nullptr), used(0), capacity(0)
+{
+	make_room(threshold);
+}
+
+OutputBuffer::~OutputBuffer()
+{
+	drain();
+	std::free(data);
+}
+
+
+void OutputBuffer::flush()
+{
+	drain();
+	sink.flush();
+}
+
+
+void OutputBuffer::drain()
+{
+	if(used) sink.write(data, used);
+	used = 0;
+}
+
+
+void OutputBuffer::make_room(std::size_t size)
+{
+	drain();
+	if(size <= capacity) return;
+	// a single write bigger than the buffer grows it rather than splitting
+	std::size_t grown = capacity ? capacity : threshold;
+	while(grown < size) grown *= 2;
+	char* bigger = static_cast<char*>(std::realloc(data, grown));
+	if(!bigger) throw std::bad_alloc();
+	data = bigger;
+	capacity = grown;
+}
+
+
+#endif // ifndef OUTPUT_BUFFER_CPP
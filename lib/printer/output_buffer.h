@@ -0,0 +1,79 @@
+#ifndef OUTPUT_BUFFER_H
+#define OUTPUT_BUFFER_H
+
+#include <cstddef>
+#include <cstring>
+#include <ostream>
+#include <string_view>
+
+
+//----------------------------------------------------------------------
+// Byte buffer in front of an output stream
+//----------------------------------------------------------------------
+
+// Output is appended to one reusable buffer and handed to the sink in
+// chunks of at least flush_threshold bytes, so serializers pay for one
+// ostream::write() per chunk instead of one << per fragment.
+class OutputBuffer
+{
+public:
+	static constexpr std::size_t DEFAULT_THRESHOLD = 64 * 1024;
+
+	explicit OutputBuffer(std::ostream& sink, std::size_t flush_threshold = DEFAULT_THRESHOLD);
+	~OutputBuffer();
+
+	OutputBuffer(const OutputBuffer&) = delete;
+	OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+	void put(char c);
+	void write(const char* data, std::size_t size);
+	void write(std::string_view text);
+
+	// hand everything buffered to the sink and flush the sink
+	void flush();
+
+	// bytes currently buffered
+	std::size_t size() const;
+
+private:
+	std::ostream& sink;
+	std::size_t threshold;
+	char* data;
+	std::size_t used;
+	std::size_t capacity;
+
+	// write the buffered bytes to the sink without flushing it
+	void drain();
+	// drain, then grow the buffer if size bytes still do not fit
+	void make_room(std::size_t size);
+};
+
+
+// the serializers call these once per token, so keep them inline
+inline void OutputBuffer::put(char c)
+{
+	if(used == capacity) make_room(1);
+	data[used++] = c;
+	if(used >= threshold) drain();
+}
+
+inline void OutputBuffer::write(const char* bytes, std::size_t size)
+{
+	if(capacity - used < size) make_room(size);
+	std::memcpy(data + used, bytes, size);
+	used += size;
+	if(used >= threshold) drain();
+}
+
+inline void OutputBuffer::write(std::string_view text)
+{
+	write(text.data(), text.size());
+}
+
+inline std::size_t OutputBuffer::size() const
+{
+	return used;
+}
+
+
+#endif // ifndef OUTPUT_BUFFER_H
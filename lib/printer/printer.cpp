@@ -1,4 +1,3 @@
-// Since this declares a definition of the Printer class, we need to typeguard it generically
 #ifndef PRINTER_CPP
 #define PRINTER_CPP
 
@@ -8,62 +7,84 @@
 
 // constructors
 Printer::Printer(std::ostream& output_stream)
-: out(output_stream), indent_size(1), indent_char('\t') {}
+: indent_size(0), indent_char(' '), out(output_stream) {}
 
 Printer::Printer(std::ostream& output_stream, const int& indent)
-: out(output_stream), indent_size(indent), indent_char(' ') {}
+: indent_size(indent), indent_char(' '), out(output_stream) {}
 
 Printer::Printer(std::ostream& output_stream, const int& indent_width, const char& indent_character)
-: out(output_stream), indent_size(indent_width), indent_char(indent_character) {}
+: indent_size(indent_width), indent_char(indent_character), out(output_stream) {}
+
+
+void Printer::flush()
+{
+	out.flush();
+}
 
 
 // Indent managers
 void Printer::inc_indent() {
 	curr_indent += indent_size;
+	if(curr_indent > static_cast<int>(indent_table.size()))
+		indent_table.resize(2 * curr_indent + 64, indent_char);
 }
 
 void Printer::dec_indent() {
 	curr_indent -= indent_size;
 }
 
-std::string Printer::get_indent() {
-	return std::string(curr_indent, indent_char);
+void Printer::new_line() {
+	if(!indent_size) return;
+	out.put('\n');
+	out.write(indent_table.data(), curr_indent);
 }
 
 // top-level
 void Printer::visit(JSONDocument& node)
 {
 	node.root->accept(*this);
-	out << std::endl;
+	if(indent_size) out.put('\n');
+	out.flush();
+}
+
+void Printer::print_record(JSONDocument& node)
+{
+	node.root->accept(*this);
+	out.put('\n');
 }
 
 void Printer::visit(JSON& node)
 {
 	if(!node.records.size())
 	{
-		out << "{}";
-		if(!curr_indent) out << std::endl;
+		out.write("{}", 2);
 		return;
 	}
 	inc_indent();
-	out << "{\n";
+	out.put('{');
 	auto it = node.records.begin();
-	(*it)->accept(*this);
+	new_line();
+	it->accept(*this);
 	++it;
 	for(; it != node.records.end(); ++it)
 	{
-		out << ",\n";
-		(*it)->accept(*this);
+		out.put(',');
+		new_line();
+		it->accept(*this);
 	}
 	dec_indent();
-	out << "\n" << get_indent() << "}";
+	new_line();
+	out.put('}');
 }
 
 void Printer::visit(Record& node)
 {
-	out << get_indent();
-	out << '"' << node.key.lexeme() << '"';
-	out << ": ";
+	out.put('"');
+	out.write(node.key.lexeme());
+	if(indent_size)
+		out.write("\": ", 3);
+	else
+		out.write("\":", 2);
 	node.value->accept(*this);
 }
 
@@ -73,10 +94,12 @@ void Printer::visit(SimpleRValue& node)
 	{
 		case LITERAL_TYPE:
 		case NUMBER_TYPE:
-			out << node.value.lexeme();
+			out.write(node.value.lexeme());
 			break;
 		case STRING_TYPE:
-			out << '"' << node.value.lexeme() << '"';
+			out.put('"');
+			out.write(node.value.lexeme());
+			out.put('"');
 			break;
 		default:
 			break; // no other types
@@ -87,21 +110,24 @@ void Printer::visit(Array& node)
 {
 	if(!node.values.size())
 	{
-		out << "[]";
+		out.write("[]", 2);
 		return;
 	}
 	inc_indent();
-	out << "[\n" << get_indent();
+	out.put('[');
 	auto it = node.values.begin();
+	new_line();
 	(*it)->accept(*this);
 	++it;
 	for(; it != node.values.end(); ++it)
 	{
-		out << ",\n" << get_indent();
+		out.put(',');
+		new_line();
 		(*it)->accept(*this);
 	}
 	dec_indent();
-	out << "\n" << get_indent() << "]";
+	new_line();
+	out.put(']');
 }
 
 
@@ -1,14 +1,25 @@
 #ifndef PRINTER_H
 #define PRINTER_H
 
-#include <iostream>
+#include <ostream>
 #include <string>
 
 // libwjson core modules
 #include <core/token.h>
 #include <core/ast.h>
+#include <printer/output_buffer.h>
 
 
+//----------------------------------------------------------------------
+// AST serializer
+//----------------------------------------------------------------------
+
+// Writes a document back out as JSON. An indent width of 0 produces
+// compact output (no whitespace at all); otherwise every value goes on
+// its own line, indented by indent_width indent_chars per level, and the
+// document ends with a newline. Output goes through an OutputBuffer and
+// reaches the stream when a document has been printed, on flush(), or
+// when the Printer is destroyed.
 class Printer : public Visitor
 {
 public:
@@ -22,20 +33,29 @@ public:
 	void visit(JSONDocument&);
 	void visit(JSON&);
 	void visit(Record&);
-	void visit(RValue&);
 	void visit(SimpleRValue&);
 	void visit(Array&);
 
+	// print a document followed by a newline, without flushing, as one
+	// record of a JSON Lines stream
+	void print_record(JSONDocument&);
+
+	// hand any buffered output to the stream
+	void flush();
+
 private:
 	const int indent_size;
 	const char indent_char;
 
-	std::ostream& out;
+	OutputBuffer out;
 	int curr_indent = 0;
+	// indent_char repeated, sliced for every line instead of built per line
+	std::string indent_table;
 
 	void inc_indent();
 	void dec_indent();
-	std::string get_indent();
+	// newline and indentation before a value (nothing when compact)
+	void new_line();
 };
 
 
@@ -0,0 +1,46 @@
+#ifndef STREAM_PRINTER_CPP
+#define STREAM_PRINTER_CPP
+
+// libwjson core modules
+#include <core/lexer.h>
+#include <core/parser.h>
+#include <printer/stream_printer.h>
+
+
+// constructors
+StreamPrinter::StreamPrinter(std::ostream& output_stream)
+: indent_size(0), indent_char(' '), out(output_stream) {}
+
+StreamPrinter::StreamPrinter(std::ostream& output_stream, const int& indent)
+: indent_size(indent), indent_char(' '), out(output_stream) {}
+
+StreamPrinter::StreamPrinter(std::ostream& output_stream, const int& indent_width, const char& indent_character)
+: indent_size(indent_width), indent_char(indent_character), out(output_stream) {}
+
+
+void StreamPrinter::print(std::string_view input)
+{
+	curr_indent = 0;
+	need_comma = open_pending = false;
+	Lexer lexer(input);
+	Parser parser(lexer);
+	parser.parse(*this);
+}
+
+void StreamPrinter::print(std::istream& input, std::size_t chunk_size)
+{
+	curr_indent = 0;
+	need_comma = open_pending = false;
+	Lexer lexer(input, chunk_size);
+	Parser parser(lexer);
+	parser.parse(*this);
+}
+
+void StreamPrinter::end_document()
+{
+	if(indent_size) out.put('\n');
+	out.flush();
+}
+
+
+#endif // ifndef STREAM_PRINTER_CPP
@@ -0,0 +1,173 @@
+#ifndef STREAM_PRINTER_H
+#define STREAM_PRINTER_H
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+// libwjson core modules
+#include <core/token.h>
+#include <core/handler.h>
+#include <printer/output_buffer.h>
+
+
+//----------------------------------------------------------------------
+// Streaming serializer
+//----------------------------------------------------------------------
+
+// Prints a document straight from the parser's events, with the same
+// indent options and byte-for-byte the same output as Printer, but
+// without building a tree: output starts with the first tokens and
+// memory only grows with the nesting depth. The input is validated as it
+// is read, so on a JSONException the output written so far is cut short.
+// (For compact output Minifier does the same with less bookkeeping.)
+class StreamPrinter final : public Handler
+{
+public:
+	// streams are read this many bytes at a time
+	static constexpr std::size_t DEFAULT_CHUNK_SIZE = 1 << 20;
+
+	// constructors (as Printer's)
+	StreamPrinter(std::ostream&);
+	StreamPrinter(std::ostream&, const int&);
+	StreamPrinter(std::ostream&, const int&, const char&);
+
+	// print one document from a buffer, or from a stream read in chunks
+	void print(std::string_view input);
+	void print(std::istream& input, std::size_t chunk_size = DEFAULT_CHUNK_SIZE);
+
+	// events (Parser::parse(Handler&) calls these)
+	void start_object(const Token&) override;
+	void key(const Token&) override;
+	void end_object(const Token&) override;
+	void start_array(const Token&) override;
+	void end_array(const Token&) override;
+	void string_value(const Token&) override;
+	void number_value(const Token&) override;
+	void literal_value(const Token&) override;
+	void end_document() override;
+
+private:
+	const int indent_size;
+	const char indent_char;
+
+	OutputBuffer out;
+	int curr_indent = 0;
+	// indent_char repeated, sliced for every line
+	std::string indent_table;
+	// whether the next value or key follows a sibling
+	bool need_comma = false;
+	// a container was opened and nothing is in it yet (an empty one
+	// prints as {} or [] on one line)
+	bool open_pending = false;
+
+	// newline and indentation (nothing when compact)
+	void new_line();
+	// separator and layout before a key or value
+	void element();
+	void open(char bracket);
+	void close(char bracket);
+};
+
+
+// one call per token, so keep the writers inline
+inline void StreamPrinter::new_line()
+{
+	if(!indent_size) return;
+	out.put('\n');
+	out.write(indent_table.data(), curr_indent);
+}
+
+inline void StreamPrinter::element()
+{
+	if(open_pending) {
+		curr_indent += indent_size;
+		if(curr_indent > static_cast<int>(indent_table.size()))
+			indent_table.resize(2 * curr_indent + 64, indent_char);
+		new_line();
+		open_pending = false;
+	} else if(need_comma) {
+		out.put(',');
+		new_line();
+	}
+}
+
+inline void StreamPrinter::open(char bracket)
+{
+	element();
+	out.put(bracket);
+	open_pending = true;
+	need_comma = false;
+}
+
+inline void StreamPrinter::close(char bracket)
+{
+	if(open_pending) {
+		open_pending = false;
+	} else {
+		curr_indent -= indent_size;
+		new_line();
+	}
+	out.put(bracket);
+	need_comma = true;
+}
+
+inline void StreamPrinter::start_object(const Token&)
+{
+	open('{');
+}
+
+inline void StreamPrinter::key(const Token& t)
+{
+	element();
+	out.put('"');
+	out.write(t.lexeme());
+	if(indent_size)
+		out.write("\": ", 3);
+	else
+		out.write("\":", 2);
+	need_comma = false;
+}
+
+inline void StreamPrinter::end_object(const Token&)
+{
+	close('}');
+}
+
+inline void StreamPrinter::start_array(const Token&)
+{
+	open('[');
+}
+
+inline void StreamPrinter::end_array(const Token&)
+{
+	close(']');
+}
+
+inline void StreamPrinter::string_value(const Token& t)
+{
+	element();
+	out.put('"');
+	out.write(t.lexeme());
+	out.put('"');
+	need_comma = true;
+}
+
+inline void StreamPrinter::number_value(const Token& t)
+{
+	element();
+	out.write(t.lexeme());
+	need_comma = true;
+}
+
+inline void StreamPrinter::literal_value(const Token& t)
+{
+	element();
+	out.write(t.lexeme());
+	need_comma = true;
+}
+
+
+#endif // ifndef STREAM_PRINTER_H
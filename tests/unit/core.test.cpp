@@ -3,19 +3,49 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <map>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <iterator>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <system_error>
+#include <unistd.h>
 
 // libwjson modules
-#include <core/token.cpp>
-#include <core/json_exception.cpp>
-#include <core/lexer.cpp>
-#include <core/parser.cpp>
-#include <core/ast.cpp>
+#include <core/token.h>
+#include <core/json_exception.h>
+#include <core/json_string.h>
+#include <core/number.h>
+#include <core/structural_index.h>
+#include <core/lexer.h>
+#include <core/binary_document.h>
+#include <core/binary_readers.h>
+#include <core/lazy_value.h>
+#include <core/mapped_file.h>
+#include <core/parser.h>
+#include <core/parallel_parser.h>
+#include <core/path_query.h>
+#include <core/ndjson.h>
+#include <core/push_parser.h>
+#include <core/dom_builder.h>
+#include <core/symbol_table.h>
+#include <core/ast.h>
+#include <core/arena.h>
+#include <core/tape.h>
 
 // GTest
 #include <gtest/gtest.h>
 
-// wjsoncompact
-#include <wjsoncompact/wjsoncompact.cpp>
+// libwjson printer
+#include <printer/printer.h>
+#include <printer/minifier.h>
+#include <printer/binary_writers.h>
+#include <printer/stream_printer.h>
 
 //----------------------------------------------------------------------
 // Constants & Macros
@@ -38,13 +68,13 @@ EXPECT_EQ(false, input.fail())
         Parser parser(lexer);\
         JSONDocument ast_root_node;\
         parser.parse(ast_root_node);\
-        EXPECT_STRCASEEQ(expectedValue, ast_root_node.root->first_token().lexeme().c_str());\
+        EXPECT_STRCASEEQ(expectedValue, string(ast_root_node.root->first_token().lexeme()).c_str());\
     } catch (JSONException e) {\
         cerr << e.to_string() << endl;\
         throw e;\
     }
 
-// We use the printer from wjsoncompact to create a minimilist representation of the AST.
+// We use the compact printer to create a minimilist representation of the AST.
 // Be mindful that this does introduce an additional mode of failure
 #define TEST_AGAINST_PRINTER(expectedValue) string rawJson = expectedValue;\
     ostringstream printerOut (ostringstream::ate);\
@@ -117,6 +147,1098 @@ TEST(WJSON_CORE, SimpleOneLine) {
     TEST_AGAINST_PRINTER("{\"configurations\":[{\"name\":\"config name\",\"includePath\":[\"{workspaceFolder}/**\"],\"defines\":[],\"frameworkPath\":[\"/my/framework/path/is/very/long/nice/frameworks\"],\"compilerPath\":\"/usr/bin/compilername\",\"cStandard\":\"c17\",\"cppStandard\":\"c++17\",\"intelliSenseMode\":\"os-compiler-arch\",\"i need another key\":true,\"again\":null},false],\"empty object\":{},\"version\":4}");
 }
 
+TEST(WJSON_CORE, BufferInput) {
+    // a lexer over an in-memory buffer should tokenize exactly like one over a stream
+    INPUT(simpleOneLine.json);
+    stringstream contents;
+    contents << input.rdbuf();
+    string buffer = contents.str();
+    istringstream stream(buffer);
+
+    Lexer streamLexer(stream);
+    Lexer bufferLexer(string_view(buffer.data(), buffer.size()));
+    Token expected, actual;
+    do {
+        expected = streamLexer.next_token();
+        actual = bufferLexer.next_token();
+        EXPECT_EQ(expected.to_string(), actual.to_string());
+    } while(expected.type() != EOS && actual.type() != EOS);
+    EXPECT_EQ(EOS, actual.type());
+}
+
+TEST(WJSON_CORE, MappedFile) {
+    INPUT(simpleOneLine.json);
+    stringstream contents;
+    contents << input.rdbuf();
+
+    // a regular file is mapped; the document points into the mapping
+    shared_ptr<MappedFile> file = make_shared<MappedFile>(TEST_FILE(simpleOneLine.json));
+    EXPECT_TRUE(file->mapped());
+    EXPECT_EQ(contents.str(), file->data());
+    JSONDocument doc;
+    Lexer lexer(file->data());
+    Parser parser(lexer);
+    parser.parse(doc);
+    doc.source = file;
+    const char* lexeme = doc.root->first_token().lexeme().data();
+    EXPECT_TRUE(lexeme >= file->data().data() && lexeme < file->data().data() + file->data().size());
+
+    // a pipe cannot be mapped and is read instead
+    int fds[2];
+    ASSERT_EQ(0, pipe(fds));
+    ASSERT_EQ(5, write(fds[1], "[1,2]", 5));
+    close(fds[1]);
+    MappedFile piped(fds[0]);
+    close(fds[0]);
+    EXPECT_FALSE(piped.mapped());
+    EXPECT_EQ("[1,2]", piped.data());
+
+    EXPECT_THROW(MappedFile("no/such/file.json"), system_error);
+}
+
+TEST(WJSON_CORE, DocumentOwnsSource) {
+    // tokens point into the lexer's buffer, so the document has to keep it alive
+    // after the stream and lexer are gone
+    JSONDocument ast_root_node;
+    {
+        istringstream stream("{\"key\": \"value\"}");
+        Lexer lexer(stream);
+        Parser parser(lexer);
+        parser.parse(ast_root_node);
+    }
+    EXPECT_EQ("key", ast_root_node.root->first_token().lexeme());
+}
+
+TEST(WJSON_CORE, ContainerNodes) {
+    // containers report their own type through RValue and keep their children
+    // in order in contiguous storage
+    istringstream stream("{\"a\": [1, {}, []], \"b\": null}");
+    Lexer lexer(stream);
+    Parser parser(lexer);
+    JSONDocument ast_root_node;
+    parser.parse(ast_root_node);
+
+    RValue* root = ast_root_node.root;
+    ASSERT_EQ(JSON_TYPE, root->type);
+    JSON& object = static_cast<JSON&>(*root);
+    ASSERT_EQ(2u, object.records.size());
+    EXPECT_EQ("a", object.records[0].key.lexeme());
+    EXPECT_EQ("b", object.records[1].key.lexeme());
+
+    ASSERT_EQ(ARRAY_TYPE, object.records[0].value->type);
+    Array& array = static_cast<Array&>(*object.records[0].value);
+    ASSERT_EQ(3u, array.values.size());
+    EXPECT_EQ(NUMBER_TYPE, array.values[0]->type);
+    EXPECT_EQ(JSON_TYPE, array.values[1]->type);
+    EXPECT_EQ(ARRAY_TYPE, array.values[2]->type);
+    // empty containers fall back to their closing token
+    EXPECT_EQ("}", array.values[1]->first_token().lexeme());
+    EXPECT_EQ("]", array.values[2]->first_token().lexeme());
+}
+
+TEST(WJSON_CORE, Tape) {
+    // the tape supports O(1) subtree skips and field lookups without an AST,
+    // and can still be walked by the existing visitors
+    INPUT_SPEC(rfc8259_obj_ex.json);
+    Lexer lexer(input);
+    Parser parser(lexer);
+    Tape tape;
+    parser.parse(tape);
+
+    ASSERT_EQ(TAPE_START_OBJECT, tape.tag(0));
+    EXPECT_EQ(tape.entries.size(), tape.next(0));
+    size_t image = tape.find_field(0, "Image");
+    ASSERT_NE(Tape::npos, image);
+    size_t thumbnail = tape.find_field(image, "Thumbnail");
+    ASSERT_NE(Tape::npos, thumbnail);
+    size_t url = tape.find_field(thumbnail, "Url");
+    ASSERT_NE(Tape::npos, url);
+    EXPECT_EQ(TAPE_STRING, tape.tag(url));
+    EXPECT_EQ("http://www.example.com/image/481989943", tape.lexeme(url));
+    EXPECT_EQ(TAPE_FALSE, tape.tag(tape.find_field(image, "Animated")));
+    EXPECT_EQ(Tape::npos, tape.find_field(image, "Missing"));
+
+    // keys match with escape sequences decoded, as in the tree
+    string escaped = "{\"\\u0041\": 1, \"B\\\"\": 2}";
+    Lexer escapedLexer(escaped);
+    Parser escapedParser(escapedLexer);
+    Tape escapedTape;
+    escapedParser.parse(escapedTape);
+    EXPECT_EQ("1", escapedTape.lexeme(escapedTape.find_field(0, "A")));
+    EXPECT_EQ("2", escapedTape.lexeme(escapedTape.find_field(0, "B\"")));
+    EXPECT_EQ(Tape::npos, escapedTape.find_field(0, "\\u0041"));
+
+    ostringstream printerOut;
+    Printer printer(printerOut);
+    tape.accept(printer);
+    EXPECT_EQ("{\"Image\":{\"Width\":800,\"Height\":600,\"Title\":\"View from 15th Floor\",\"Thumbnail\":{\"Url\":\"http://www.example.com/image/481989943\",\"Height\":125,\"Width\":100},\"Animated\":false,\"IDs\":[116,943,234,38793]}}", printerOut.str());
+}
+
+TEST(WJSON_CORE, PrinterIndent) {
+    string json = "{\"a\": [1, {}, []], \"b\": {\"c\": \"d\"}}";
+    Lexer lexer(json);
+    Parser parser(lexer);
+    JSONDocument doc;
+    parser.parse(doc);
+
+    ostringstream formatted;
+    Printer printer(formatted, 2);
+    doc.accept(printer);
+    EXPECT_EQ("{\n  \"a\": [\n    1,\n    {},\n    []\n  ],\n  \"b\": {\n    \"c\": \"d\"\n  }\n}\n", formatted.str());
+
+    // chunks reach the stream once the threshold is crossed, and writes
+    // larger than the buffer are not split
+    ostringstream sink;
+    {
+        OutputBuffer buffer(sink, 4);
+        buffer.write("abc");
+        EXPECT_EQ("", sink.str());
+        buffer.put('d');
+        EXPECT_EQ("abcd", sink.str());
+        buffer.write("0123456789");
+        EXPECT_EQ("abcd0123456789", sink.str());
+        buffer.put('!');
+    }
+    EXPECT_EQ("abcd0123456789!", sink.str());
+}
+
+// records events as text, copying lexemes since streamed tokens are transient
+class EventLog : public Handler
+{
+public:
+    string log;
+    void start_object(const Token&) override { log += "{"; }
+    void key(const Token& t) override { log += "k:" + string(t.lexeme()) + " "; }
+    void end_object(const Token&) override { log += "} "; }
+    void start_array(const Token&) override { log += "["; }
+    void end_array(const Token&) override { log += "] "; }
+    void string_value(const Token& t) override { log += "s:" + string(t.lexeme()) + " "; }
+    void number_value(const Token& t) override { log += "n:" + string(t.lexeme()) + " "; }
+    void literal_value(const Token& t) override { log += "l:" + string(t.lexeme()) + " "; }
+    void end_document() override { log += "$"; }
+};
+
+TEST(WJSON_CORE, Minifier) {
+    // the same bytes as the compact Printer, from a buffer or a stream
+    // read a few bytes at a time
+    for(const char* file : {TEST_SPEC_FILE(rfc8259_obj_ex.json), TEST_SPEC_FILE(rfc8259_arr_ex.json),
+                            TEST_FILE(numbers.json), TEST_FILE(simpleOneLine.json)}) {
+        ifstream input(file);
+        string json((istreambuf_iterator<char>(input)), istreambuf_iterator<char>());
+        ostringstream printed;
+        Lexer lexer(json);
+        Parser parser(lexer);
+        JSONDocument doc;
+        parser.parse(doc);
+        Printer printer(printed);
+        doc.accept(printer);
+
+        ostringstream minified;
+        Minifier minifier(minified);
+        minifier.minify(json);
+        EXPECT_EQ(printed.str(), minified.str());
+
+        ostringstream streamed;
+        Minifier streamMinifier(streamed);
+        istringstream stream(json);
+        streamMinifier.minify(stream, 7);
+        EXPECT_EQ(printed.str(), streamed.str());
+    }
+
+    ostringstream out;
+    Minifier minifier(out);
+    minifier.minify(" [ {\"a\" : [ ] , \"b\":{ }} , \"x\\\" y\" ,1e5,null ] ");
+    EXPECT_EQ("[{\"a\":[],\"b\":{}},\"x\\\" y\",1e5,null]", out.str());
+    EXPECT_THROW(minifier.minify("[1, 2,]"), JSONException);
+}
+
+TEST(WJSON_CORE, StreamPrinter) {
+    // the same bytes as Printer with the same options
+    string nested = "{\"a\": [], \"b\": {}, \"c\": [[{}], {\"d\": [1, \"x\", null]}], \"e\": {\"f\": {\"g\": true}}}";
+    for(const char* file : {TEST_SPEC_FILE(rfc8259_obj_ex.json), TEST_SPEC_FILE(rfc8259_arr_ex.json),
+                            TEST_FILE(numbers.json), TEST_SPEC_FILE(literal.json), ""}) {
+        string json = nested;
+        if(*file) {
+            ifstream input(file);
+            json.assign(istreambuf_iterator<char>(input), istreambuf_iterator<char>());
+        }
+        Lexer lexer(json);
+        Parser parser(lexer);
+        JSONDocument doc;
+        parser.parse(doc);
+        for(int indent : {0, 1, 4}) {
+            ostringstream printed;
+            Printer printer(printed, indent, indent == 1 ? '\t' : ' ');
+            doc.accept(printer);
+
+            ostringstream streamed;
+            StreamPrinter streamPrinter(streamed, indent, indent == 1 ? '\t' : ' ');
+            streamPrinter.print(json);
+            EXPECT_EQ(printed.str(), streamed.str());
+
+            ostringstream chunked;
+            StreamPrinter chunkPrinter(chunked, indent, indent == 1 ? '\t' : ' ');
+            istringstream stream(json);
+            chunkPrinter.print(stream, 5);
+            EXPECT_EQ(printed.str(), chunked.str());
+        }
+    }
+
+    ostringstream out;
+    StreamPrinter printer(out, 2);
+    EXPECT_THROW(printer.print("{\"a\": [1, 2}"), JSONException);
+}
+
+TEST(WJSON_CORE, StreamingEvents) {
+    string json = "{\"name\": \"a \\\"quoted\\\" \\u00e9 value\", \"list\": [1, -2.5e10, true, null,\n"
+                  "  {\"nested\": []}], \"long number\": 123456789012345678901234567890}";
+
+    EventLog buffered;
+    Lexer lexer(json);
+    Parser parser(lexer);
+    parser.parse(buffered);
+    EXPECT_EQ("{k:name s:a \\\"quoted\\\" \\u00e9 value k:list [n:1 n:-2.5e10 l:true l:null {k:nested [] } ] "
+              "k:long number n:123456789012345678901234567890 } $", buffered.log);
+
+    // every chunk size splits some token; the events must not change
+    for(size_t chunk = 1; chunk < 40; ++chunk) {
+        istringstream in(json);
+        EventLog streamed;
+        Lexer streamLexer(in, chunk);
+        EXPECT_FALSE(streamLexer.stable_tokens());
+        Parser streamParser(streamLexer);
+        streamParser.parse(streamed);
+        EXPECT_EQ(buffered.log, streamed.log) << "chunk size " << chunk;
+
+        // the DOM builder copies lexemes out of the window
+        istringstream domIn(json);
+        Lexer domLexer(domIn, chunk);
+        Parser domParser(domLexer);
+        JSONDocument doc;
+        domParser.parse(doc);
+        ostringstream out;
+        Printer printer(out);
+        doc.accept(printer);
+        EXPECT_EQ("{\"name\":\"a \\\"quoted\\\" \\u00e9 value\",\"list\":[1,-2.5e10,true,null,{\"nested\":[]}],"
+                  "\"long number\":123456789012345678901234567890}", out.str());
+    }
+
+    // errors keep their position across chunk boundaries
+    istringstream bad("[1, 2,\n  tru]");
+    Lexer badLexer(bad, 3);
+    Parser badParser(badLexer);
+    EventLog ignored;
+    try {
+        badParser.parse(ignored);
+        FAIL() << "expected a lexer error";
+    } catch(JSONException& e) {
+        EXPECT_NE(string::npos, e.to_string().find("line 2"));
+    }
+}
+
+TEST(WJSON_CORE, PushParser) {
+    string json = "{\"name\": \"a \\\"quoted\\\" \\u00e9 \xe2\x9c\x93\", \"list\": [1, -2.5e10, true, null,\n"
+                  "  {\"nested\": []}], \"n\": 12345678901234567890}";
+
+    EventLog whole;
+    Lexer lexer(json);
+    Parser parser(lexer);
+    parser.parse(whole);
+
+    // any split, including inside escapes and UTF-8 sequences
+    for(size_t chunk = 1; chunk <= json.size(); ++chunk) {
+        EventLog pushed;
+        PushParser push(pushed);
+        PushParser::Status status = PushParser::NEED_MORE_INPUT;
+        for(size_t pos = 0; pos < json.size(); pos += chunk) {
+            EXPECT_EQ(PushParser::NEED_MORE_INPUT, status);
+            status = push.feed(string_view(json).substr(pos, chunk));
+        }
+        EXPECT_EQ(PushParser::DONE, status) << "chunk size " << chunk;
+        push.finish();
+        EXPECT_EQ(whole.log, pushed.log) << "chunk size " << chunk;
+    }
+
+    // a top-level number is only complete at the end of input
+    EventLog number;
+    PushParser numberParser(number);
+    EXPECT_EQ(PushParser::NEED_MORE_INPUT, numberParser.feed("12"));
+    EXPECT_EQ(PushParser::NEED_MORE_INPUT, numberParser.feed("34"));
+    numberParser.finish();
+    EXPECT_EQ("n:1234 $", number.log);
+
+    // several values, e.g. one per line
+    EventLog values;
+    PushParser valuesParser(values, true);
+    valuesParser.feed("{\"a\":1}\n[tr");
+    valuesParser.feed("ue]\n\"x\"");
+    valuesParser.finish();
+    EXPECT_EQ("{k:a n:1 } $[l:true ] $s:x $", values.log);
+
+    // errors are reported where the tokenizer would report them
+    EventLog ignored;
+    PushParser bad(ignored);
+    try {
+        bad.feed("[1, 2,\n  tr");
+        bad.feed("u]");
+        FAIL() << "expected a lexer error";
+    } catch(JSONException& e) {
+        EXPECT_EQ("Lexer Error: Invalid token '\"tru' at line 2 column 3", e.to_string());
+    }
+    bad.reset();
+    bad.feed("[1, 2");
+    try {
+        bad.finish();
+        FAIL() << "expected a syntax error";
+    } catch(JSONException& e) {
+        EXPECT_NE(string::npos, e.to_string().find("expected ']'"));
+    }
+}
+
+TEST(WJSON_CORE, NDJSON) {
+    string input;
+    vector<string> expected;
+    for(int i = 0; i < 200; ++i) {
+        string record = "{\"id\":" + to_string(i) + ",\"tags\":[\"t" + to_string(i % 7) + "\",null]}";
+        expected.push_back(record);
+        input += record + (i % 3 ? "\n" : " \r\n");
+        if(i % 50 == 0) input += "\n";
+    }
+
+    auto compact = [](JSONDocument& doc) {
+        ostringstream out;
+        Printer printer(out);
+        printer.print_record(doc);
+        printer.flush();
+        return out.str().substr(0, out.str().size() - 1);
+    };
+
+    // small batches so every thread gets several, some ending mid-record
+    for(unsigned threads : {1u, 4u}) {
+        NDJSONReader reader(threads);
+        reader.set_batch_size(97);
+        vector<string> records;
+        reader.read(input, [&](JSONDocument& doc, size_t offset) {
+            EXPECT_EQ(input.compare(offset, 6, "{\"id\":"), 0);
+            records.push_back(compact(doc));
+        });
+        EXPECT_EQ(expected, records) << threads << " threads";
+
+        istringstream in(input);
+        vector<string> streamed;
+        reader.read(in, [&](JSONDocument& doc, size_t) { streamed.push_back(compact(doc)); });
+        EXPECT_EQ(expected, streamed) << threads << " threads, stream";
+    }
+
+    // unordered: every record exactly once, in any order
+    NDJSONReader unordered(4, NDJSONReader::UNORDERED);
+    unordered.set_batch_size(64);
+    mutex lock;
+    vector<string> records;
+    unordered.read(input, [&](JSONDocument& doc, size_t) {
+        string record = compact(doc);
+        lock_guard<mutex> guard(lock);
+        records.push_back(record);
+    });
+    vector<string> sorted = expected;
+    sort(sorted.begin(), sorted.end());
+    sort(records.begin(), records.end());
+    EXPECT_EQ(sorted, records);
+
+    // errors report the line in the whole input, after the records before it
+    string bad = "[1]\n\n[2]\n[3,]\n[4]\n";
+    for(unsigned threads : {1u, 3u}) {
+        NDJSONReader reader(threads);
+        reader.set_batch_size(4);
+        int delivered = 0;
+        try {
+            reader.read(bad, [&](JSONDocument&, size_t) { ++delivered; });
+            FAIL() << "expected a syntax error";
+        } catch(JSONException& e) {
+            EXPECT_EQ("Parser Error: Unexpected token: expected value, found ']' at line 4 column 4", e.to_string());
+        }
+        EXPECT_EQ(2, delivered);
+    }
+}
+
+TEST(WJSON_CORE, ParallelParser) {
+    string json = "  [\n";
+    for(int i = 0; i < 300; ++i) {
+        if(i) json += i % 5 ? ", " : ",\n";
+        json += "{\"id\": " + to_string(i) + ", \"s\": \"a,b]\\\"[\", \"v\": [" + to_string(i % 3) + ", {}]}";
+    }
+    json += "\n]\n";
+
+    JSONDocument serial;
+    Lexer lexer(json);
+    Parser parser(lexer);
+    parser.parse(serial);
+
+    // small pieces so each of the threads parses several
+    JSONDocument parallel;
+    ParallelParser parallelParser(4);
+    parallelParser.set_chunk_size(256);
+    parallelParser.parse(json, parallel);
+
+    Array* expected = static_cast<Array*>(serial.root);
+    Array* actual = static_cast<Array*>(parallel.root);
+    ASSERT_EQ(ARRAY_TYPE, parallel.root->type);
+    ASSERT_EQ(expected->values.size(), actual->values.size());
+    for(size_t i = 0; i < expected->values.size(); ++i)
+        EXPECT_EQ(expected->values[i]->first_token().to_string(), actual->values[i]->first_token().to_string());
+    EXPECT_EQ(expected->rbracket_token.to_string(), actual->rbracket_token.to_string());
+    ostringstream expectedOut, actualOut;
+    Printer expectedPrinter(expectedOut), actualPrinter(actualOut);
+    serial.accept(expectedPrinter);
+    parallel.accept(actualPrinter);
+    EXPECT_EQ(expectedOut.str(), actualOut.str());
+
+    // the cuts are found outside of strings only
+    vector<StructuralIndex::Split> splits = StructuralIndex::split_array(json, 256);
+    ASSERT_LE(3u, splits.size());
+    EXPECT_EQ(2u, splits.front().offset);
+    EXPECT_EQ(json.size() - 2, splits.back().offset);
+    for(const StructuralIndex::Split& split : splits)
+        EXPECT_EQ(split.offset == 2 ? '[' : split.offset == json.size() - 2 ? ']' : ',', json[split.offset]);
+
+    // an error in a piece is reported exactly as the serial parser does
+    string bad = json;
+    bad.replace(bad.find("\"id\": 250"), 10, "\"id\": 25x");
+    string serialError, parallelError;
+    try {
+        Lexer badLexer(bad);
+        Parser badParser(badLexer);
+        JSONDocument doc;
+        badParser.parse(doc);
+    } catch(JSONException& e) {
+        serialError = e.to_string();
+    }
+    try {
+        JSONDocument doc;
+        parallelParser.parse(bad, doc);
+    } catch(JSONException& e) {
+        parallelError = e.to_string();
+    }
+    EXPECT_NE("", serialError);
+    EXPECT_EQ(serialError, parallelError);
+
+    // other documents are parsed serially
+    JSONDocument object;
+    parallelParser.parse("{\"a\": [1, 2, 3]}", object);
+    EXPECT_EQ(JSON_TYPE, object.root->type);
+}
+
+TEST(WJSON_CORE, DeepNesting) {
+    // a million levels: the parse does not recurse, so only the limit stops it
+    const size_t depth = 1000000;
+    string json = string(depth, '[') + "1" + string(depth, ']');
+
+    JSONDocument doc;
+    Lexer lexer(json);
+    Parser parser(lexer);
+    parser.set_max_depth(0);
+    parser.parse(doc);
+    Array* innermost = static_cast<Array*>(doc.root);
+    for(size_t i = 1; i < depth; ++i)
+        innermost = static_cast<Array*>(innermost->values[0]);
+    EXPECT_EQ("1", innermost->values[0]->first_token().lexeme());
+
+    // the default limit, reported at the bracket that exceeds it
+    Lexer limitedLexer(json);
+    Parser limited(limitedLexer);
+    try {
+        JSONDocument rejected;
+        limited.parse(rejected);
+        FAIL() << "expected a depth error";
+    } catch(JSONException& e) {
+        EXPECT_EQ("Parser Error: Maximum nesting depth of 1024 exceeded, found '[' at line 1 column 1025", e.to_string());
+    }
+
+    // empty containers count too; objects and arrays alike
+    for(string nested : {"[[[]]]", "[{\"a\":{}}]", "{\"a\":[[1]]}"}) {
+        Lexer shallowLexer(nested);
+        Parser shallow(shallowLexer);
+        shallow.set_max_depth(2);
+        JSONDocument rejected;
+        EXPECT_THROW(shallow.parse(rejected), JSONException) << nested;
+        Lexer okLexer(nested);
+        Parser ok(okLexer);
+        ok.set_max_depth(3);
+        JSONDocument accepted;
+        EXPECT_NO_THROW(ok.parse(accepted)) << nested;
+
+        JSONDocument pushed;
+        DOMBuilder pushedBuilder(pushed, true);
+        PushParser shallowPush(pushedBuilder, false, 2);
+        EXPECT_THROW(shallowPush.feed(nested), JSONException) << nested;
+        PushParser okPush(pushedBuilder, false, 3);
+        EXPECT_EQ(PushParser::DONE, okPush.feed(nested)) << nested;
+    }
+
+    // the push parser has the same default limit and error, across chunks
+    JSONDocument pushed;
+    DOMBuilder builder(pushed, true);
+    PushParser pushParser(builder);
+    try {
+        for(size_t i = 0; i < json.size(); i += 4096)
+            pushParser.feed(string_view(json).substr(i, 4096));
+        FAIL() << "expected a depth error";
+    } catch(JSONException& e) {
+        EXPECT_EQ("Parser Error: Maximum nesting depth of 1024 exceeded, found '[' at line 1 column 1025", e.to_string());
+    }
+    JSONDocument unlimited;
+    DOMBuilder unlimitedBuilder(unlimited, true);
+    PushParser unlimitedParser(unlimitedBuilder, false, 0);
+    EXPECT_EQ(PushParser::DONE, unlimitedParser.feed(json));
+}
+
+TEST(WJSON_CORE, MemberLookup) {
+    INPUT_SPEC(rfc8259_obj_ex.json);
+    Lexer lexer(input);
+    Parser parser(lexer);
+    JSONDocument doc;
+    parser.parse(doc);
+    RValue& root = *doc.root;
+    EXPECT_EQ("http://www.example.com/image/481989943", static_cast<SimpleRValue&>(root["Image"]["Thumbnail"]["Url"]).as_string());
+    EXPECT_EQ(125, static_cast<SimpleRValue&>(root["Image"]["Thumbnail"]["Height"]).as_int64());
+    JSON& image = static_cast<JSON&>(root["Image"]);
+    EXPECT_TRUE(image.contains("IDs"));
+    EXPECT_FALSE(image.contains("ids"));
+    EXPECT_EQ(nullptr, image.find("Missing"));
+    EXPECT_THROW(root["Image"]["Nope"], JSONException);
+    EXPECT_THROW(root["Image"]["Width"]["x"], JSONException);
+
+    // small and indexed objects alike: escaped keys match decoded, the
+    // first of duplicate keys wins
+    for(int members : {4, 100}) {
+        string json = "{\"A\\u0042c\": 1, \"dup\": 2, \"dup\": 3";
+        for(int i = 0; i < members; ++i)
+            json += ", \"key" + to_string(i) + "\": " + to_string(i);
+        json += "}";
+        Lexer objectLexer(json);
+        Parser objectParser(objectLexer);
+        JSONDocument object;
+        objectParser.parse(object);
+        JSON& obj = static_cast<JSON&>(*object.root);
+        EXPECT_EQ(1, static_cast<SimpleRValue&>(obj["ABc"]).as_int64());
+        EXPECT_FALSE(obj.contains("A\\u0042c"));
+        EXPECT_EQ(2, static_cast<SimpleRValue&>(obj["dup"]).as_int64());
+        for(int i = 0; i < members; ++i)
+            EXPECT_EQ(i, static_cast<SimpleRValue&>(obj["key" + to_string(i)]).as_int64());
+        EXPECT_FALSE(obj.contains("key" + to_string(members)));
+
+        // the index is built with the tree, so lookups may run concurrently
+        atomic<int> misses(0);
+        vector<thread> readers;
+        for(int t = 0; t < 4; ++t)
+            readers.emplace_back([&] {
+                for(int i = 0; i < members; ++i)
+                    if(!obj.find("key" + to_string(i))) ++misses;
+            });
+        for(thread& reader : readers)
+            reader.join();
+        EXPECT_EQ(0, misses);
+    }
+}
+
+TEST(WJSON_CORE, LazyValue) {
+    INPUT_SPEC(rfc8259_obj_ex.json);
+    string json((istreambuf_iterator<char>(input)), istreambuf_iterator<char>());
+    LazyValue root = LazyValue::root(json);
+    EXPECT_EQ(JSON_TYPE, root.type());
+    LazyValue thumbnail = root["Image"]["Thumbnail"];
+    EXPECT_EQ("http://www.example.com/image/481989943", thumbnail["Url"].as_string());
+    EXPECT_EQ(125, thumbnail["Height"].as_int64());
+    EXPECT_EQ(8, thumbnail["Height"].first_token().line());
+    EXPECT_EQ("Thumbnail", thumbnail.key_string());
+    EXPECT_EQ(38793, root["Image"]["IDs"].at(3).as_int64());
+    EXPECT_THROW(root["Image"]["IDs"].at(4), JSONException);
+    EXPECT_THROW(root["Image"]["Nope"], JSONException);
+    EXPECT_THROW(root["Image"]["Title"].as_int64(), JSONException);
+    EXPECT_EQ("false", root["Image"]["Animated"].text());
+
+    string keys;
+    for(const LazyValue& member : root["Image"])
+        keys += member.key_string() + ",";
+    EXPECT_EQ("Width,Height,Title,Thumbnail,Animated,IDs,", keys);
+
+    // a materialized subtree prints like the same subtree of the full tree
+    LazyValue image = root["Image"];
+    EXPECT_EQ('{', image.text().front());
+    EXPECT_EQ('}', image.text().back());
+    JSONDocument doc;
+    image.parse(doc);
+    ostringstream lazyOut;
+    Printer lazyPrinter(lazyOut);
+    doc.accept(lazyPrinter);
+    EXPECT_EQ(3, doc.root->first_token().line());
+    EXPECT_EQ("{\"Width\":800,\"Height\":600,\"Title\":\"View from 15th Floor\",\"Thumbnail\":{\"Url\":\"http://www.example.com/image/481989943\",\"Height\":125,\"Width\":100},\"Animated\":false,\"IDs\":[116,943,234,38793]}", lazyOut.str());
+
+    // skipped values are only bracket-matched; what is read is checked
+    string skipped = "{\"a\": [1, {\"b\": \"]}\\\"\"}, x], \"c\": 2, \"d\": [1 2]}";
+    EXPECT_EQ(2, LazyValue::root(skipped)["c"].as_int64());
+    EXPECT_THROW(LazyValue::root(skipped)["a"].at(2), JSONException);
+    EXPECT_THROW(LazyValue::root(skipped)["d"].at(1), JSONException);
+    try {
+        LazyValue::root("[[1, 2]")["x"];
+        FAIL();
+    } catch(JSONException& e) {
+        EXPECT_EQ("Type Error: value is not an object at line 1 column 1", e.to_string());
+    }
+    try {
+        LazyValue::root("[[1, 2]").at(1);
+        FAIL();
+    } catch(JSONException& e) {
+        EXPECT_EQ("Parser Error: Unexpected token: expected ']', found '' at line 1 column 8", e.to_string());
+    }
+}
+
+TEST(WJSON_CORE, PathQuery) {
+    string json = "{\"a\": {\"b\": [10, {\"c\": 1}, {\"c\": 2}], \"x~y\": 3, \"p/q\": 4, \"c\": 5}, \"d\": [{\"c\": 6}], \"a\": 7}";
+    PathQuery query;
+    EXPECT_EQ(0, query.add("/a/b/1/c"));
+    query.add("$.a.b[*].c");
+    query.add("$..c");
+    query.add("/a/x~0y");
+    query.add("/a/p~1q");
+    query.add("");
+    query.add("$['a'][\"b\"][0]");
+    query.add("/a/missing");
+    query.add("/d/0");
+    EXPECT_EQ(9, query.add("$.*"));
+    EXPECT_EQ(10, query.size());
+
+    // the same matches in the same order from the tree and the text
+    auto compact = [](JSONDocument& doc) {
+        ostringstream out;
+        Printer printer(out);
+        doc.accept(printer);
+        return out.str();
+    };
+    vector<string> fromTree, fromText;
+    Lexer lexer(json);
+    Parser parser(lexer);
+    JSONDocument doc;
+    parser.parse(doc);
+    query.evaluate(doc, [&](size_t path, RValue& value) {
+        JSONDocument match;
+        match.root = &value;
+        fromTree.push_back(to_string(path) + ":" + compact(match));
+        match.root = nullptr;
+    });
+    query.evaluate(json, [&](size_t path, const LazyValue& value) {
+        JSONDocument match;
+        value.parse(match);
+        fromText.push_back(to_string(path) + ":" + compact(match));
+    });
+    EXPECT_EQ(fromTree, fromText);
+    map<size_t, string> byPath;
+    for(const string& m : fromText) {
+        size_t colon = m.find(':');
+        byPath[stoul(m.substr(0, colon))] += m.substr(colon + 1) + " ";
+    }
+    EXPECT_EQ("1 ", byPath[0]);
+    EXPECT_EQ("1 2 ", byPath[1]);
+    EXPECT_EQ("1 2 5 6 ", byPath[2]);
+    EXPECT_EQ("3 ", byPath[3]);
+    EXPECT_EQ("4 ", byPath[4]);
+    EXPECT_EQ(compact(doc) + " ", byPath[5]);
+    EXPECT_EQ("10 ", byPath[6]);
+    EXPECT_EQ(0, byPath.count(7));
+    EXPECT_EQ("{\"c\":6} ", byPath[8]);
+    EXPECT_EQ("{\"b\":[10,{\"c\":1},{\"c\":2}],\"x~y\":3,\"p/q\":4,\"c\":5} [{\"c\":6}] 7 ", byPath[9]);
+
+    // once every path without wildcards has matched nothing more is read,
+    // but what is read is checked
+    PathQuery first;
+    first.add("/a");
+    int matches = 0;
+    first.evaluate("{\"a\": 1, \"b\": [1 2}", [&](size_t, const LazyValue& value) {
+        EXPECT_EQ(1, value.as_int64());
+        ++matches;
+    });
+    EXPECT_EQ(1, matches);
+    EXPECT_THROW(first.evaluate("{\"b\" 1, \"a\": 1}", [](size_t, const LazyValue&) {}), JSONException);
+
+    // paths that match the same value are all reported, by both walks
+    PathQuery overlapping;
+    overlapping.add("/a");
+    overlapping.add("$.a");
+    overlapping.add("/a");
+    string small = "{\"a\": 1, \"b\": 2}";
+    Lexer smallLexer(small);
+    Parser smallParser(smallLexer);
+    JSONDocument smallDoc;
+    smallParser.parse(smallDoc);
+    vector<size_t> treePaths, textPaths;
+    overlapping.evaluate(smallDoc, [&](size_t path, RValue&) { treePaths.push_back(path); });
+    overlapping.evaluate(small, [&](size_t path, const LazyValue&) { textPaths.push_back(path); });
+    EXPECT_EQ(vector<size_t>({0, 1, 2}), treePaths);
+    EXPECT_EQ(treePaths, textPaths);
+
+    for(const char* invalid : {"a/b", "/~2", "$.", "$a", "$[x]", "$['a'", "$[1"})
+        EXPECT_THROW(query.add(invalid), JSONException);
+}
+
+TEST(WJSON_CORE, BinaryDocument) {
+    for(const char* file : {TEST_SPEC_FILE(rfc8259_obj_ex.json), TEST_SPEC_FILE(rfc8259_arr_ex.json),
+                            TEST_FILE(numbers.json), TEST_SPEC_FILE(literal.json)}) {
+        ifstream input(file);
+        string json((istreambuf_iterator<char>(input)), istreambuf_iterator<char>());
+        Lexer lexer(json);
+        Parser parser(lexer);
+        JSONDocument doc;
+        parser.parse(doc);
+        ostringstream printed;
+        Printer printer(printed);
+        doc.accept(printer);
+
+        // from the tree and straight from the text alike
+        string fromTree, fromText;
+        BinaryWriter(fromTree).write(doc);
+        BinaryWriter(fromText).write(json);
+        EXPECT_EQ(fromTree, fromText);
+        ASSERT_TRUE(BinaryDocument::is_binary(fromTree));
+        EXPECT_FALSE(BinaryDocument::is_binary(json));
+
+        // back to the same compact text, by events or through a tree
+        BinaryDocument binary(fromTree);
+        ostringstream replayed;
+        Minifier minifier(replayed);
+        binary.root().replay(minifier);
+        minifier.end_document();
+        EXPECT_EQ(printed.str(), replayed.str());
+        JSONDocument reloaded;
+        binary.parse(reloaded);
+        ostringstream reprinted;
+        Printer reprinter(reprinted);
+        reloaded.accept(reprinter);
+        EXPECT_EQ(printed.str(), reprinted.str());
+    }
+
+    // read in place
+    string bytes;
+    BinaryWriter writer(bytes);
+    writer.write("{\"Image\": {\"IDs\": [116, 943, 234, 38793], \"T\\u0069tle\": \"View \\\"15\\\"\", \"On\": false}}");
+    BinaryValue root = BinaryDocument(bytes).root();
+    EXPECT_EQ(JSON_TYPE, root.type());
+    EXPECT_EQ(38793, root["Image"]["IDs"].at(3).as_int64());
+    EXPECT_EQ(4u, root["Image"]["IDs"].size());
+    EXPECT_EQ("View \"15\"", root["Image"]["Title"].as_string());
+    EXPECT_EQ("T\\u0069tle", root["Image"].key(1));
+    EXPECT_EQ("false", root["Image"].value(2).lexeme());
+    EXPECT_EQ(LITERAL_TYPE, root["Image"]["On"].type());
+    EXPECT_THROW(root["Image"]["IDs"].at(4), JSONException);
+    EXPECT_THROW(root["Image"]["Nope"], JSONException);
+    EXPECT_THROW(root["Image"].as_string(), JSONException);
+
+    // a second document appends; a cut one is rejected
+    size_t first = bytes.size();
+    writer.write("[1]");
+    EXPECT_EQ(1, BinaryDocument(string_view(bytes).substr(first)).root().at(0).as_int64());
+    EXPECT_THROW(BinaryDocument(string_view(bytes).substr(0, first - 1)), JSONException);
+    size_t second = bytes.size();
+    EXPECT_THROW(writer.write("[1, }"), JSONException);
+    EXPECT_EQ(second, bytes.size());
+
+    // the other byte order keeps the magic but not the version
+    string swapped;
+    BinaryWriter(swapped).write("[1]");
+    reverse(swapped.begin() + 4, swapped.begin() + 8);
+    EXPECT_TRUE(BinaryDocument::is_binary(swapped));
+    EXPECT_THROW(BinaryDocument{swapped}, JSONException);
+
+    // children that share or overlap bytes are rejected as damaged: [1, 2]
+    // with both table entries on the first element, and [[1, 2], 3] with
+    // the second entry inside the first element
+    string shared;
+    BinaryWriter(shared).write("[1, 2]");
+    memcpy(&shared[41], &shared[37], 4);
+    EXPECT_THROW(BinaryDocument(shared).root().at(1), JSONException);
+    JSONDocument sharedTree;
+    EXPECT_THROW(BinaryDocument(shared).parse(sharedTree), JSONException);
+    string overlapping;
+    BinaryWriter(overlapping).write("[[1, 2], 3]");
+    BinaryValue outer = BinaryDocument(overlapping).root();
+    uint32_t inside = 9 + 9 + 6;
+    memcpy(&overlapping[16 + 48], &inside, 4);
+    EXPECT_EQ(1, outer.at(0).at(0).as_int64());
+    EXPECT_THROW(outer.at(1), JSONException);
+}
+
+TEST(WJSON_CORE, CBORAndMessagePack) {
+    auto bytes = [](const string& hex) {
+        string out;
+        for(size_t i = 0; i + 1 < hex.size(); i += 3)
+            out += static_cast<char>(stoi(hex.substr(i, 2), nullptr, 16));
+        return out;
+    };
+    auto compact = [](JSONDocument& doc) {
+        ostringstream out;
+        Printer printer(out);
+        doc.accept(printer);
+        return out.str();
+    };
+    CBORReader cbor;
+    auto fromCBOR = [&](const string& hex) {
+        JSONDocument doc;
+        cbor.parse(bytes(hex), doc);
+        return compact(doc);
+    };
+    MessagePackReader msgpack;
+    auto fromMessagePack = [&](const string& hex) {
+        JSONDocument doc;
+        msgpack.parse(bytes(hex), doc);
+        return compact(doc);
+    };
+
+    // RFC 8949 appendix A examples
+    EXPECT_EQ("1000", fromCBOR("19 03 e8 "));
+    EXPECT_EQ("-18446744073709551616", fromCBOR("3b ff ff ff ff ff ff ff ff "));
+    EXPECT_EQ("1", fromCBOR("f9 3c 00 "));
+    EXPECT_EQ("-4.1", fromCBOR("fb c0 10 66 66 66 66 66 66 "));
+    EXPECT_EQ("1e+05", fromCBOR("fa 47 c3 50 00 "));
+    EXPECT_EQ("null", fromCBOR("f9 7e 00 "));
+    EXPECT_EQ("\"AQIDBA\"", fromCBOR("44 01 02 03 04 "));
+    EXPECT_EQ("\"\xc3\xbc\\n\"", fromCBOR("63 c3 bc 0a "));
+    EXPECT_EQ("\"2013-03-21T20:04:00Z\"", fromCBOR("c0 74 32 30 31 33 2d 30 33 2d 32 31 54 32 30 3a 30 34 3a 30 30 5a "));
+    EXPECT_EQ("[1,[2,3],[4,5]]", fromCBOR("9f 01 82 02 03 9f 04 05 ff ff "));
+    EXPECT_EQ("{\"Fun\":true,\"Amt\":-2}", fromCBOR("bf 63 46 75 6e f5 63 41 6d 74 21 ff "));
+    EXPECT_EQ("\"streaming\"", fromCBOR("7f 65 73 74 72 65 61 64 6d 69 6e 67 ff "));
+    EXPECT_EQ("{\"1\":2,\"3\":4}", fromCBOR("a2 01 02 03 04 "));
+    EXPECT_THROW(fromCBOR("82 01 "), JSONException);
+    EXPECT_THROW(fromCBOR("01 02 "), JSONException);
+    EXPECT_THROW(fromCBOR("a1 80 01 "), JSONException);
+    EXPECT_THROW(fromCBOR("ff "), JSONException);
+
+    EXPECT_EQ("{\"compact\":true,\"schema\":0}", fromMessagePack("82 a7 63 6f 6d 70 61 63 74 c3 a6 73 63 68 65 6d 61 00 "));
+    EXPECT_EQ("[-1,-200,65535,null,false,1.5,\"AQI\"]", fromMessagePack("97 ff d1 ff 38 cd ff ff c0 c2 cb 3f f8 00 00 00 00 00 00 c4 02 01 02 "));
+    EXPECT_THROW(fromMessagePack("92 01 "), JSONException);
+    EXPECT_THROW(fromMessagePack("d4 01 00 "), JSONException);
+
+    // writers: smallest integer forms, doubles otherwise, decoded text
+    string json = "{\"a\": [1, -1, 1.5, \"x\\n\", true, null, 300, -40000]}";
+    Lexer lexer(json);
+    Parser parser(lexer);
+    JSONDocument doc;
+    parser.parse(doc);
+    ostringstream cborOut, msgpackOut;
+    CBORWriter cborWriter(cborOut);
+    doc.accept(cborWriter);
+    MessagePackWriter msgpackWriter(msgpackOut);
+    doc.accept(msgpackWriter);
+    EXPECT_EQ(bytes("a1 61 61 88 01 20 fb 3f f8 00 00 00 00 00 00 62 78 0a f5 f6 19 01 2c 39 9c 3f "), cborOut.str());
+    EXPECT_EQ(bytes("81 a1 61 98 01 ff cb 3f f8 00 00 00 00 00 00 a2 78 0a c3 c0 cd 01 2c d2 ff ff 63 c0 "), msgpackOut.str());
+
+    // the same tree back from either format
+    for(const char* file : {TEST_SPEC_FILE(rfc8259_obj_ex.json), TEST_SPEC_FILE(rfc8259_arr_ex.json), TEST_FILE(numbers.json)}) {
+        ifstream input(file);
+        string text((istreambuf_iterator<char>(input)), istreambuf_iterator<char>());
+        Lexer fileLexer(text);
+        Parser fileParser(fileLexer);
+        JSONDocument original;
+        fileParser.parse(original);
+        ostringstream encodedCBOR, encodedMessagePack;
+        CBORWriter toCBOR(encodedCBOR);
+        original.accept(toCBOR);
+        MessagePackWriter toMessagePack(encodedMessagePack);
+        original.accept(toMessagePack);
+        JSONDocument a, b;
+        cbor.parse(encodedCBOR.str(), a);
+        msgpack.parse(encodedMessagePack.str(), b);
+        EXPECT_EQ(compact(a), compact(b));
+        if(string(file).find("obj_ex") != string::npos) {
+            EXPECT_EQ(compact(original), compact(a));
+        }
+    }
+}
+
+TEST(WJSON_CORE, SymbolTable) {
+    INPUT_SPEC(rfc8259_arr_ex.json);
+    string json((istreambuf_iterator<char>(input)), istreambuf_iterator<char>());
+    SymbolTable symbols;
+    JSONDocument docs[2];
+    for(JSONDocument& doc : docs) {
+        // a streaming lexer, whose tokens do not outlive the parse
+        istringstream stream(json);
+        Lexer lexer(stream, 16);
+        Parser parser(lexer);
+        parser.set_symbol_table(&symbols);
+        parser.parse(doc);
+    }
+    EXPECT_EQ(8u, symbols.size());
+    JSON& first = static_cast<JSON&>(*static_cast<Array&>(*docs[0].root).values[0]);
+    for(JSONDocument& doc : docs) {
+        for(RValue* value : static_cast<Array&>(*doc.root).values) {
+            JSON& record = static_cast<JSON&>(*value);
+            for(size_t i = 0; i < record.records.size(); ++i)
+                EXPECT_EQ(first.records[i].key.lexeme().data(), record.records[i].key.lexeme().data());
+        }
+    }
+    EXPECT_EQ("City", first.records[4].key_string());
+    EXPECT_EQ("SUNNYVALE", static_cast<SimpleRValue&>((*static_cast<Array&>(*docs[0].root).values[1])["City"]).as_string());
+
+    std::string_view city = symbols.find("City");
+    EXPECT_EQ(first.records[4].key.lexeme().data(), city.data());
+    EXPECT_EQ(symbols.intern("City").data(), city.data());
+    EXPECT_EQ(SymbolTable::hash(city), SymbolTable::hash(first.records[4].key.lexeme()));
+    EXPECT_EQ(nullptr, symbols.find("city").data());
+
+    // symbol lookups match by pointer, in small and indexed objects alike;
+    // equal text at another address is not the symbol
+    for(JSONDocument& doc : docs) {
+        JSON& record = static_cast<JSON&>(*static_cast<Array&>(*doc.root).values[1]);
+        EXPECT_EQ(&record["City"], record.find_symbol(city));
+    }
+    string cityText = "City";
+    EXPECT_EQ(nullptr, first.find_symbol(cityText));
+    string wide = "{\"\\u0041\": 0";
+    for(int i = 0; i < 40; ++i)
+        wide += ", \"w" + to_string(i) + "\": " + to_string(i);
+    wide += "}";
+    Lexer wideLexer(wide);
+    Parser wideParser(wideLexer);
+    wideParser.set_symbol_table(&symbols);
+    JSONDocument wideDoc;
+    wideParser.parse(wideDoc);
+    JSON& wideObject = static_cast<JSON&>(*wideDoc.root);
+    for(int i = 0; i < 40; ++i) {
+        RValue* value = wideObject.find_symbol(symbols.find("w" + to_string(i)));
+        ASSERT_NE(nullptr, value);
+        EXPECT_EQ(i, static_cast<SimpleRValue*>(value)->as_int64());
+        EXPECT_EQ(nullptr, wideObject.find_symbol("w" + to_string(i)));
+    }
+    EXPECT_EQ(&wideObject["A"], wideObject.find_symbol(symbols.find("\\u0041")));
+    EXPECT_EQ(nullptr, wideObject.find_symbol(city));
+
+    // growing keeps every symbol where it is
+    for(int i = 0; i < 1000; ++i)
+        symbols.intern("k" + to_string(i));
+    EXPECT_EQ(1049u, symbols.size());
+    EXPECT_EQ(city.data(), symbols.find("City").data());
+    EXPECT_EQ(symbols.intern("k500").data(), symbols.find("k500").data());
+    EXPECT_EQ(1049u, symbols.size());
+    symbols.clear();
+    EXPECT_EQ(0u, symbols.size());
+    EXPECT_EQ(nullptr, symbols.find("City").data());
+}
+
+TEST(WJSON_CORE, StructuralIndex) {
+    // every kernel must agree with the scalar one, including on escapes and
+    // backslash runs that straddle 64-byte blocks
+    string json = "{\"a\\\\\": [1, -2.5e3, true, null, \"x\\\"y\"],";
+    json += string(50, ' ') + "\"\\\\\\\"\\\\\" : {\"[\": \"]\"}, \"k\": false}";
+
+    StructuralIndex scalar;
+    scalar.build(json, StructuralIndex::SCALAR);
+    for(StructuralIndex::Implementation impl : {StructuralIndex::SSE42, StructuralIndex::AVX2}) {
+        if(!StructuralIndex::supported(impl)) continue;
+        StructuralIndex simd;
+        simd.build(json, impl);
+        EXPECT_EQ(scalar.positions, simd.positions) << StructuralIndex::name(impl);
+    }
+
+    // the lexer produces the same tokens with and without the index
+    Lexer plain(json);
+    Lexer indexed(json);
+    indexed.use_structural_index();
+    Token expected, actual;
+    do {
+        expected = plain.next_token();
+        actual = indexed.next_token();
+        EXPECT_EQ(expected.to_string(), actual.to_string());
+    } while(expected.type() != EOS && actual.type() != EOS);
+
+    StructuralIndex unterminated;
+    EXPECT_THROW(unterminated.build("[\"abc\\\"]", StructuralIndex::SCALAR), JSONException);
+    EXPECT_THROW(unterminated.build("[\"ab\nc\"]"), JSONException);
+}
+
+TEST(WJSON_CORE, StringEscapes) {
+    // lexemes keep the raw escapes; decoding happens on request
+    istringstream stream("[\"tab\\there \\\"quoted\\\" \\u00e9 \\ud83d\\ude00 \\/\"]");
+    Lexer lexer(stream);
+    Parser parser(lexer);
+    JSONDocument ast_root_node;
+    parser.parse(ast_root_node);
+    SimpleRValue& value = static_cast<SimpleRValue&>(*static_cast<Array&>(*ast_root_node.root).values[0]);
+    EXPECT_EQ("tab\\there \\\"quoted\\\" \\u00e9 \\ud83d\\ude00 \\/", value.value.lexeme());
+    EXPECT_EQ("tab\there \"quoted\" \xc3\xa9 \xf0\x9f\x98\x80 /", value.as_string());
+
+    // escaping round-trips through decoding
+    string escaped;
+    escape_json_string(value.as_string() + string("\x01\n", 2), escaped);
+    EXPECT_EQ("tab\\there \\\"quoted\\\" \xc3\xa9 \xf0\x9f\x98\x80 /\\u0001\\n", escaped);
+    string decoded;
+    unescape_json_string(escaped, decoded);
+    EXPECT_EQ(value.as_string() + string("\x01\n", 2), decoded);
+
+    // invalid escapes are rejected by the lexer, with or without the index
+    for(bool indexed : {false, true}) {
+        istringstream bad("[\"a\\qb\"]");
+        Lexer badLexer(bad);
+        if(indexed) badLexer.use_structural_index();
+        EXPECT_THROW(badLexer.next_token(); badLexer.next_token(), JSONException);
+    }
+}
+
+TEST(WJSON_CORE, NumberConversion) {
+    INPUT(numbers.json);
+    Lexer lexer(input);
+    Parser parser(lexer);
+    JSONDocument ast_root_node;
+    parser.parse(ast_root_node);
+    map<string, SimpleRValue*> numbers;
+    for(Record& r : static_cast<JSON&>(*ast_root_node.root).records)
+        numbers[string(r.key.lexeme())] = static_cast<SimpleRValue*>(r.value);
+
+    int64_t i;
+    double d;
+    EXPECT_EQ(3, numbers["int"]->as_int64());
+    EXPECT_EQ(-20, numbers["negative"]->as_int64());
+    EXPECT_EQ(10000u, numbers["exp"]->as_uint64());
+    EXPECT_EQ(810, numbers["exp with plus"]->as_int64());
+    EXPECT_EQ(-400000, numbers["negative exp"]->as_int64());
+    EXPECT_EQ(NUMBER_INEXACT, numbers["decimal"]->get_int64(i));
+    EXPECT_THROW(numbers["exp with minus"]->as_int64(), JSONException);
+    EXPECT_EQ(NUMBER_OVERFLOW, numbers["big exp"]->get_int64(i));
+    EXPECT_EQ(NUMBER_EXACT, numbers["big exp"]->get_double(d));
+    EXPECT_EQ(2e21, d);
+    EXPECT_EQ(NUMBER_INEXACT, numbers["decimal"]->get_double(d));
+    EXPECT_EQ(1.3, d);
+    EXPECT_EQ(NUMBER_EXACT, numbers["leading 0 decimal"]->get_double(d));
+    EXPECT_EQ(0.5, d);
+    EXPECT_EQ(-23e-6, numbers["negative exp with minus"]->as_double());
+    EXPECT_EQ(51.53e29, numbers["exp with frac and exp"]->as_double());
+    // cached values are returned again
+    EXPECT_EQ(51.53e29, numbers["exp with frac and exp"]->as_double());
+
+    // range limits
+    string limits = "[18446744073709551615, -9223372036854775808, 9223372036854775808, 1e400, -1e-400, 9007199254740993]";
+    Lexer limitsLexer(limits);
+    Parser limitsParser(limitsLexer);
+    JSONDocument limitsDoc;
+    limitsParser.parse(limitsDoc);
+    NodeSpan<RValue*>& values = static_cast<Array&>(*limitsDoc.root).values;
+    auto number = [&](size_t n) { return static_cast<SimpleRValue*>(values[n]); };
+    uint64_t u;
+    EXPECT_EQ(18446744073709551615ull, number(0)->as_uint64());
+    EXPECT_EQ(NUMBER_OVERFLOW, number(0)->get_int64(i));
+    EXPECT_EQ(INT64_MIN, number(1)->as_int64());
+    EXPECT_EQ(NUMBER_OVERFLOW, number(1)->get_uint64(u));
+    EXPECT_EQ(NUMBER_OVERFLOW, number(2)->get_int64(i));
+    EXPECT_THROW(number(3)->as_double(), JSONException);
+    EXPECT_EQ(NUMBER_INEXACT, number(4)->get_double(d));
+    EXPECT_EQ(0.0, d);
+    EXPECT_EQ(NUMBER_INEXACT, number(5)->get_double(d));
+
+    // the short-decimal fast path and the general path round the same way
+    for (const char* text : {"0.1", "-3.14159", "123456789e-22", "9007199254740992e22", "1.7976931348623157e308"}) {
+        parse_json_double(text, d);
+        EXPECT_EQ(std::strtod(text, nullptr), d) << text;
+    }
+}
+
 // TODO: Add a test(s) that actually looks through the lexemes of something non-trivial
 
 